@@ -0,0 +1,443 @@
+// C++ BigNum template class
+// AKA the integer doubler template.
+// Copyright(C) 2007,2015 Jeremy Linton
+//
+// Source identity: BatchInt.hpp
+//
+// Add/subtract/compare whole arrays of integers at once:
+//
+//   AddN(dst,a,b,n);        // dst[x]=a[x]+b[x]
+//   SubN(dst,a,b,n);        // dst[x]=a[x]-b[x]
+//   CompareN(res,a,b,n);    // res[x]=-1,0,1 like a[x]<=>b[x]
+//   EqualN(res,a,b,n);      // res[x]=a[x]==b[x]
+//
+// One at a time each add is a single adc chain, which is as long as the
+// integer and leaves most of the core idle. Here the limbs of several
+// integers sit side by side in one AVX-512 (8 limbs) or AVX2 (4 limbs)
+// register and are added without carries. Each lane's carry out (s<a) and
+// whether it would pass a carry on (s==~0) go into bit masks, and the
+// carries for every lane come out of one ordinary add on the masks:
+//
+//   carry_in=((generate<<1)+propagate)^propagate
+//
+// The masks have the integers' top limbs cleared so nothing crosses from
+// one integer into the next. The arrays are used in place, the limbs of an
+// integer are already next to each other. Integers wider than a register
+// pass the carry between registers. Subtract is the same with borrows.
+//
+// The integer types have to be flat (DoubleInt_t, FixedInt_t, int128_t) and
+// the limb count a power of two for the vector paths. The leftover
+// integers, other limb counts and CPUs without AVX2 use the types' own
+// AddDouble/SubDouble/compares. DOUBLEINT_NO_AVX512 and DOUBLEINT_NO_AVX2
+// turn the vector paths off.
+//
+// See DoubleInt_t.hpp for more information
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+// USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef BATCHINT_HPP
+#define BATCHINT_HPP
+
+#include <stddef.h>
+#include <immintrin.h>
+#include "DoubleInt_t.hpp"
+
+// cpuid leaf 7 for the feature bits, and xgetbv to make sure the OS saves the
+// wide registers (AVX: XMM/YMM state, AVX-512: opmask/ZMM state too)
+static inline bool CpuHasSimd(const int Bit,const unsigned int XcrMask)
+{
+    unsigned int a=0,b,c=0,d;
+    asm ("cpuid" : "+a" (a), "=b" (b), "+c" (c), "=d" (d));
+    if (a<7)
+    {
+        return false;
+    }
+    a=1;
+    c=0;
+    asm ("cpuid" : "+a" (a), "=b" (b), "+c" (c), "=d" (d));
+    if (!((c>>27)&1)) //OSXSAVE
+    {
+        return false;
+    }
+    unsigned int xlo,xhi;
+    asm ("xgetbv" : "=a" (xlo), "=d" (xhi) : "c" (0));
+    if ((xlo&XcrMask)!=XcrMask)
+    {
+        return false;
+    }
+    a=7;
+    c=0;
+    asm ("cpuid" : "+a" (a), "=b" (b), "+c" (c), "=d" (d));
+    return (b>>Bit)&1;
+}
+
+static inline bool CpuHasAvx2()
+{
+#ifdef DOUBLEINT_NO_AVX2
+    return false;
+#else
+    return CpuHasSimd(5,0x6);
+#endif
+}
+
+static inline bool CpuHasAvx512()
+{
+#ifdef DOUBLEINT_NO_AVX512
+    return false;
+#else
+    return CpuHasSimd(16,0xe6);
+#endif
+}
+
+static const bool DoubleIntHaveAvx2=CpuHasAvx2();
+static const bool DoubleIntHaveAvx512=CpuHasAvx512();
+
+
+// Where the integers start and end in a register of Lanes limbs. With
+// Limbs<=Lanes a register holds whole integers, otherwise an integer covers
+// Limbs/Lanes registers and only the last one has its top limb in it.
+// Returns false if the limbs don't line up with the lanes.
+static inline bool BatchLayout(const int Limbs,const int Lanes,unsigned int *TopMask)
+{
+    *TopMask=0;
+    if (Limbs<Lanes)
+    {
+        if (Lanes%Limbs)
+        {
+            return false;
+        }
+        for (int x=Limbs-1;x<Lanes;x+=Limbs)
+        {
+            *TopMask|=1u<<x;
+        }
+        return true;
+    }
+    *TopMask=1u<<(Lanes-1);
+    return (Limbs%Lanes)==0;
+}
+
+// The carry (or borrow) into each lane from the generate/propagate masks of
+// one register, CarryIn is the carry from the register below and gets the
+// carry out of this one. Top limbs don't generate or propagate.
+static inline unsigned int BatchCarries(unsigned int Generate,unsigned int Propagate,const unsigned int Top,unsigned int *CarryIn,const int Lanes)
+{
+    Generate&=~Top;
+    Propagate&=~Top;
+    unsigned int sum=((Generate<<1)|*CarryIn)+Propagate;
+    *CarryIn=(sum>>Lanes)&1;
+    return (sum^Propagate)&((1u<<Lanes)-1);
+}
+
+// -1,0,1 from the lanes that are greater and less, the highest lane that
+// differs wins and it's also the highest set bit of the two masks
+static inline int BatchSign(const unsigned int Greater,const unsigned int Less)
+{
+    return (Greater>Less)-(Greater<Less);
+}
+
+
+//
+//
+//          AVX-512, 8 limbs a register
+//
+//
+
+// R=A+B (Sub: R=A-B) for N integers of Limbs limbs, Limbs a multiple or a
+// divisor of 8, N*Limbs a multiple of 8
+__attribute__((target("avx512f"))) static inline void AddSubLimbsAvx512(int64 *R,const int64 *A,const int64 *B,const int Limbs,const size_t N,const bool Sub)
+{
+    unsigned int top;
+    BatchLayout(Limbs,8,&top);
+    const size_t regs=N*Limbs/8;
+    const size_t per=(Limbs>8)?Limbs/8:1;
+    const __m512i ones=_mm512_set1_epi64(-1);
+    const __m512i one=_mm512_set1_epi64(1);
+    unsigned int carry=0;
+    for (size_t x=0;x<regs;x++)
+    {
+        __m512i a=_mm512_loadu_si512(&A[x*8]);
+        __m512i b=_mm512_loadu_si512(&B[x*8]);
+        unsigned int t=((x%per)==per-1)?top:0;
+        if ((x%per)==0)
+        {
+            carry=0;
+        }
+        __m512i s;
+        unsigned int c;
+        if (Sub)
+        {
+            s=_mm512_sub_epi64(a,b);
+            c=BatchCarries(_mm512_cmplt_epu64_mask(a,b),_mm512_cmpeq_epi64_mask(s,_mm512_setzero_si512()),t,&carry,8);
+            s=_mm512_mask_sub_epi64(s,(__mmask8)c,s,one);
+        }
+        else
+        {
+            s=_mm512_add_epi64(a,b);
+            c=BatchCarries(_mm512_cmplt_epu64_mask(s,a),_mm512_cmpeq_epi64_mask(s,ones),t,&carry,8);
+            s=_mm512_mask_add_epi64(s,(__mmask8)c,s,one);
+        }
+        _mm512_storeu_si512(&R[x*8],s);
+    }
+}
+
+// Result[x]=A[x]<=>B[x] (Equal: A[x]==B[x]), same layout rules as above.
+// Wide integers are compared from their top register down.
+__attribute__((target("avx512f"))) static inline void CompareLimbsAvx512(int *Result,const int64 *A,const int64 *B,const int Limbs,const size_t N,const bool Equal)
+{
+    if (Limbs>8)
+    {
+        const int per=Limbs/8;
+        for (size_t x=0;x<N;x++)
+        {
+            int sign=0;
+            for (int y=per-1;(y>=0) && (sign==0);y--)
+            {
+                __m512i a=_mm512_loadu_si512(&A[x*Limbs+y*8]);
+                __m512i b=_mm512_loadu_si512(&B[x*Limbs+y*8]);
+                if (Equal)
+                {
+                    sign=(_mm512_cmpneq_epi64_mask(a,b)!=0);
+                }
+                else
+                {
+                    sign=BatchSign(_mm512_cmpgt_epu64_mask(a,b),_mm512_cmplt_epu64_mask(a,b));
+                }
+            }
+            Result[x]=Equal?!sign:sign;
+        }
+        return;
+    }
+    const int count=8/Limbs;
+    const unsigned int full=(1u<<Limbs)-1;
+    for (size_t x=0;x<N/count;x++)
+    {
+        __m512i a=_mm512_loadu_si512(&A[x*8]);
+        __m512i b=_mm512_loadu_si512(&B[x*8]);
+        unsigned int gt=_mm512_cmpgt_epu64_mask(a,b);
+        unsigned int lt=_mm512_cmplt_epu64_mask(a,b);
+        for (int y=0;y<count;y++)
+        {
+            unsigned int g=(gt>>(y*Limbs))&full;
+            unsigned int l=(lt>>(y*Limbs))&full;
+            Result[x*count+y]=Equal?((g|l)==0):BatchSign(g,l);
+        }
+    }
+}
+
+
+//
+//
+//          AVX2, 4 limbs a register
+//
+//
+
+// the AVX2 compares are signed, flipping the top bit makes them unsigned
+__attribute__((target("avx2"))) static inline unsigned int LessMask256(__m256i A,__m256i B)
+{
+    const __m256i bias=_mm256_set1_epi64x((int64)0x8000000000000000ULL);
+    return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_xor_si256(B,bias),_mm256_xor_si256(A,bias))));
+}
+
+__attribute__((target("avx2"))) static inline unsigned int EqualMask256(__m256i A,__m256i B)
+{
+    return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(A,B)));
+}
+
+__attribute__((target("avx2"))) static inline void AddSubLimbsAvx2(int64 *R,const int64 *A,const int64 *B,const int Limbs,const size_t N,const bool Sub)
+{
+    unsigned int top;
+    BatchLayout(Limbs,4,&top);
+    const size_t regs=N*Limbs/4;
+    const size_t per=(Limbs>4)?Limbs/4:1;
+    const __m256i ones=_mm256_set1_epi64x(-1);
+    const __m256i lanes=_mm256_set_epi64x(8,4,2,1);
+    unsigned int carry=0;
+    for (size_t x=0;x<regs;x++)
+    {
+        __m256i a=_mm256_loadu_si256((const __m256i *)&A[x*4]);
+        __m256i b=_mm256_loadu_si256((const __m256i *)&B[x*4]);
+        unsigned int t=((x%per)==per-1)?top:0;
+        if ((x%per)==0)
+        {
+            carry=0;
+        }
+        __m256i s;
+        unsigned int c;
+        if (Sub)
+        {
+            s=_mm256_sub_epi64(a,b);
+            c=BatchCarries(LessMask256(a,b),EqualMask256(s,_mm256_setzero_si256()),t,&carry,4);
+        }
+        else
+        {
+            s=_mm256_add_epi64(a,b);
+            c=BatchCarries(LessMask256(s,a),EqualMask256(s,ones),t,&carry,4);
+        }
+        // the carry bits as lanes of -1, subtracting that adds one
+        __m256i cv=_mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(c),lanes),lanes);
+        s=Sub?_mm256_add_epi64(s,cv):_mm256_sub_epi64(s,cv);
+        _mm256_storeu_si256((__m256i *)&R[x*4],s);
+    }
+}
+
+__attribute__((target("avx2"))) static inline void CompareLimbsAvx2(int *Result,const int64 *A,const int64 *B,const int Limbs,const size_t N,const bool Equal)
+{
+    if (Limbs>4)
+    {
+        const int per=Limbs/4;
+        for (size_t x=0;x<N;x++)
+        {
+            int sign=0;
+            for (int y=per-1;(y>=0) && (sign==0);y--)
+            {
+                __m256i a=_mm256_loadu_si256((const __m256i *)&A[x*Limbs+y*4]);
+                __m256i b=_mm256_loadu_si256((const __m256i *)&B[x*Limbs+y*4]);
+                if (Equal)
+                {
+                    sign=(EqualMask256(a,b)!=0xf);
+                }
+                else
+                {
+                    sign=BatchSign(LessMask256(b,a),LessMask256(a,b));
+                }
+            }
+            Result[x]=Equal?!sign:sign;
+        }
+        return;
+    }
+    const int count=4/Limbs;
+    const unsigned int full=(1u<<Limbs)-1;
+    for (size_t x=0;x<N/count;x++)
+    {
+        __m256i a=_mm256_loadu_si256((const __m256i *)&A[x*4]);
+        __m256i b=_mm256_loadu_si256((const __m256i *)&B[x*4]);
+        unsigned int gt=LessMask256(b,a);
+        unsigned int lt=LessMask256(a,b);
+        for (int y=0;y<count;y++)
+        {
+            unsigned int g=(gt>>(y*Limbs))&full;
+            unsigned int l=(lt>>(y*Limbs))&full;
+            Result[x*count+y]=Equal?((g|l)==0):BatchSign(g,l);
+        }
+    }
+}
+
+
+//
+//
+//          The flat limb entry points, these return how many of the N
+//          integers they did, the caller does the rest one at a time
+//
+//
+
+// how many of N integers fill whole registers of Lanes limbs, 0 if the limb
+// count doesn't fit them
+static inline size_t BatchCount(const int Limbs,const size_t N,const int Lanes)
+{
+    unsigned int top;
+    if (!BatchLayout(Limbs,Lanes,&top))
+    {
+        return 0;
+    }
+    return (Limbs>=Lanes)?N:N-N%(Lanes/Limbs);
+}
+
+static inline size_t AddSubLimbsN(int64 *R,const int64 *A,const int64 *B,const int Limbs,const size_t N,const bool Sub)
+{
+    size_t count=0;
+    if (DoubleIntHaveAvx512 && (count=BatchCount(Limbs,N,8)))
+    {
+        AddSubLimbsAvx512(R,A,B,Limbs,count,Sub);
+    }
+    else if (DoubleIntHaveAvx2 && (count=BatchCount(Limbs,N,4)))
+    {
+        AddSubLimbsAvx2(R,A,B,Limbs,count,Sub);
+    }
+    return count;
+}
+
+static inline size_t CompareLimbsN(int *Result,const int64 *A,const int64 *B,const int Limbs,const size_t N,const bool Equal)
+{
+    size_t count=0;
+    if (DoubleIntHaveAvx512 && (count=BatchCount(Limbs,N,8)))
+    {
+        CompareLimbsAvx512(Result,A,B,Limbs,count,Equal);
+    }
+    else if (DoubleIntHaveAvx2 && (count=BatchCount(Limbs,N,4)))
+    {
+        CompareLimbsAvx2(Result,A,B,Limbs,count,Equal);
+    }
+    return count;
+}
+
+
+//
+//
+//          The typed versions
+//
+//
+
+template<class IntT> using IfFlat_t=typename std::enable_if<sizeof(IntT)==IntT::limbs*sizeof(int64),int>::type;
+
+// Dst[x]=A[x]+B[x], Dst may be A or B
+template<class IntT,IfFlat_t<IntT> =0> void AddN(IntT *Dst,const IntT *A,const IntT *B,const size_t N)
+{
+    size_t done=AddSubLimbsN(IntT::LimbPtr(Dst),IntT::LimbPtr(*A),IntT::LimbPtr(*B),IntT::limbs,N,false);
+    for (size_t x=done;x<N;x++)
+    {
+        IntT tmp=A[x];
+        IntT::AddDouble(&tmp,B[x],0);
+        Dst[x]=tmp;
+    }
+}
+
+// Dst[x]=A[x]-B[x]
+template<class IntT,IfFlat_t<IntT> =0> void SubN(IntT *Dst,const IntT *A,const IntT *B,const size_t N)
+{
+    size_t done=AddSubLimbsN(IntT::LimbPtr(Dst),IntT::LimbPtr(*A),IntT::LimbPtr(*B),IntT::limbs,N,true);
+    for (size_t x=done;x<N;x++)
+    {
+        IntT tmp=A[x];
+        IntT::SubDouble(&tmp,B[x],0);
+        Dst[x]=tmp;
+    }
+}
+
+// Result[x]=-1 if A[x]<B[x], 0 if they are equal, 1 if A[x]>B[x]
+template<class IntT,IfFlat_t<IntT> =0> void CompareN(int *Result,const IntT *A,const IntT *B,const size_t N)
+{
+    size_t done=CompareLimbsN(Result,IntT::LimbPtr(*A),IntT::LimbPtr(*B),IntT::limbs,N,false);
+    for (size_t x=done;x<N;x++)
+    {
+        IntT a=A[x];
+        Result[x]=(a==B[x])?0:((a<B[x])?-1:1);
+    }
+}
+
+// Result[x]=1 if A[x]==B[x], 0 otherwise
+template<class IntT,IfFlat_t<IntT> =0> void EqualN(int *Result,const IntT *A,const IntT *B,const size_t N)
+{
+    size_t done=CompareLimbsN(Result,IntT::LimbPtr(*A),IntT::LimbPtr(*B),IntT::limbs,N,true);
+    for (size_t x=done;x<N;x++)
+    {
+        IntT a=A[x];
+        Result[x]=(a==B[x]);
+    }
+}
+
+#endif // BATCHINT_HPP
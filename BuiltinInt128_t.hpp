@@ -0,0 +1,392 @@
+// C++ BigNum template class
+// AKA the integer doubler template.
+// Copyright(C) 2007,2015 Jeremy Linton
+//
+// Source identity: BuiltinInt128_t.hpp
+//
+// A second int128 for the bottom of the doubler, with the same interface and
+// the same layout (Lo then Hi) as int128_t, but written with compiler
+// builtins instead of inline asm. The carry chains use __builtin_addcll and
+// __builtin_subcll where the compiler has them (clang, gcc 14), the x86
+// add-with-carry builtins otherwise, and plain unsigned __int128 anywhere
+// else. The multiplies are unsigned __int128 products. The compiler can see
+// through these, so it can schedule across them, keep the carries in the
+// flags and the halves in registers between the nesting levels, which it
+// can't do with the asm blocks. Which one wins depends on the compiler, the
+// unit test times both at each width. Pick it with the template parameter:
+//
+//   typedef class DoubleInt_t<BuiltinInt128_t> bint256;
+//   typedef class DoubleInt_t<bint256>         bint512;
+//
+// The flat limb kernels (FastMultiply.hpp etc.) are shared, so only the
+// widths that recurse all the way down see a difference. For multiplies
+// that is below DOUBLEINT_FLAT_MULTIPLY_BITS, outside the Comba range
+// (DOUBLEINT_COMBA_MIN_BITS to DOUBLEINT_COMBA_BITS).
+//
+// See DoubleInt_t.hpp for more information
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+// USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef BUILTININT128_T_HPP
+#define BUILTININT128_T_HPP
+
+#include "int128_t.hpp"
+
+typedef unsigned __int128 uint128;
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_addcll) && __has_builtin(__builtin_subcll)
+#define DOUBLEINT_HAVE_ADDCLL 1
+#endif
+#endif
+
+// A+B+carry, carry out in *CarryOut.
+static inline uint64 AddCarry64(const uint64 A,const uint64 B,const uint64 Carry,uint64 *CarryOut)
+{
+#ifdef DOUBLEINT_HAVE_ADDCLL
+    unsigned long long carry_out;
+    uint64 ret=__builtin_addcll(A,B,Carry,&carry_out);
+    *CarryOut=carry_out;
+    return ret;
+#elif defined(__x86_64__)
+    unsigned long long ret;
+    *CarryOut=__builtin_ia32_addcarryx_u64((unsigned char)Carry,A,B,&ret);
+    return ret;
+#else
+    uint128 t=(uint128)A+B+Carry;
+    *CarryOut=(uint64)(t>>64);
+    return (uint64)t;
+#endif
+}
+
+// A-B-borrow, borrow out in *BorrowOut
+static inline uint64 SubBorrow64(const uint64 A,const uint64 B,const uint64 Borrow,uint64 *BorrowOut)
+{
+#ifdef DOUBLEINT_HAVE_ADDCLL
+    unsigned long long borrow_out;
+    uint64 ret=__builtin_subcll(A,B,Borrow,&borrow_out);
+    *BorrowOut=borrow_out;
+    return ret;
+#elif defined(__x86_64__)
+    unsigned long long ret;
+    *BorrowOut=__builtin_ia32_sbb_u64((unsigned char)Borrow,A,B,&ret);
+    return ret;
+#else
+    uint128 t=(uint128)A-B-Borrow;
+    *BorrowOut=(uint64)(t>>64)&1;
+    return (uint64)t;
+#endif
+}
+
+
+class BuiltinInt128_t
+{
+    public:
+        // construction/casting
+        constexpr BuiltinInt128_t()                  :Lo(0),Hi(0) {}
+        BuiltinInt128_t(const BuiltinInt128_t &orig)=default;
+        constexpr BuiltinInt128_t(const int64 &orig) :Lo(orig),Hi(0) {}
+        // assignment
+        BuiltinInt128_t &operator= (const BuiltinInt128_t &rhs)=default;
+        // compariston, unsigned
+        bool     operator==(const BuiltinInt128_t &rhs) const { return (Lo==rhs.Lo) && (Hi==rhs.Hi);}
+        bool     operator!=(const BuiltinInt128_t &rhs) const { return (Lo!=rhs.Lo) || (Hi!=rhs.Hi);}
+        bool     operator>=(const BuiltinInt128_t &rhs) const { return Get(*this)>=Get(rhs);}
+        bool     operator<=(const BuiltinInt128_t &rhs) const { return Get(*this)<=Get(rhs);}
+        bool     operator> (const BuiltinInt128_t &rhs) const { return Get(*this)>Get(rhs);}
+        bool     operator< (const BuiltinInt128_t &rhs) const { return Get(*this)<Get(rhs);}
+        // operations (these are exported for user use)
+        BuiltinInt128_t &operator>>=(const int      rhs)  { shiftrightn(this,rhs); return *this;}
+        BuiltinInt128_t &operator<<=(const int      rhs)  { shiftleftn(this,rhs); return *this;}
+        BuiltinInt128_t &operator-=( const BuiltinInt128_t &rhs) { SubDouble(this,rhs,0); return *this;}
+        BuiltinInt128_t &operator+=( const BuiltinInt128_t &rhs) { AddDouble(this,rhs,0); return *this;}
+        BuiltinInt128_t &operator*=( const BuiltinInt128_t &rhs) { MultiplyLow(this,rhs); return *this;}
+        BuiltinInt128_t &operator/=( const BuiltinInt128_t &rhs) { DivideDouble(this,rhs); return *this;}
+        BuiltinInt128_t &operator%=( const BuiltinInt128_t &rhs) { *this=DivideDouble(this,rhs); return *this;}
+
+        BuiltinInt128_t &operator&=( const int64 &rhs) { Lo&=rhs; return *this;}
+        BuiltinInt128_t &operator|=( const int64 &rhs) { Lo|=rhs; return *this;}
+        BuiltinInt128_t &operator^=( const int64 &rhs) { Lo^=rhs; return *this;}
+
+        BuiltinInt128_t &operator&=( const BuiltinInt128_t &rhs) { Lo&=rhs.Lo; Hi&=rhs.Hi; return *this;}
+        BuiltinInt128_t &operator|=( const BuiltinInt128_t &rhs) { Lo|=rhs.Lo; Hi|=rhs.Hi; return *this;}
+        BuiltinInt128_t &operator^=( const BuiltinInt128_t &rhs) { Lo^=rhs.Lo; Hi^=rhs.Hi; return *this;}
+
+        BuiltinInt128_t operator+(   const BuiltinInt128_t &rhs) { BuiltinInt128_t tmp=*this; AddDouble(&tmp,rhs,0); return tmp;}
+        BuiltinInt128_t operator-(   const BuiltinInt128_t &rhs) { BuiltinInt128_t tmp=*this; SubDouble(&tmp,rhs,0); return tmp;}
+        BuiltinInt128_t operator/(   const BuiltinInt128_t &rhs) { BuiltinInt128_t tmp=*this; DivideDouble(&tmp,rhs); return tmp;}
+        BuiltinInt128_t operator%(   const BuiltinInt128_t &rhs) { BuiltinInt128_t tmp=*this; tmp=DivideDouble(&tmp,rhs); return tmp;}
+        BuiltinInt128_t operator*(   const BuiltinInt128_t &rhs) { BuiltinInt128_t tmp=*this; MultiplyLow(&tmp,rhs); return tmp;}
+        BuiltinInt128_t Square() { BuiltinInt128_t tmp=*this; SquareDouble(&tmp); return tmp;}
+
+        BuiltinInt128_t operator&(   const int64    &rhs) { BuiltinInt128_t tmp=*this; tmp&=rhs; return tmp;}
+        BuiltinInt128_t operator|(   const int64    &rhs) { BuiltinInt128_t tmp=*this; tmp|=rhs; return tmp;}
+        BuiltinInt128_t operator^(   const int64    &rhs) { BuiltinInt128_t tmp=*this; tmp^=rhs; return tmp;}
+
+        BuiltinInt128_t operator>>(  const int      &rhs) { BuiltinInt128_t tmp=*this; tmp>>=rhs; return tmp;}
+        BuiltinInt128_t operator<<(  const int      &rhs) { BuiltinInt128_t tmp=*this; tmp<<=rhs; return tmp;}
+
+        // input/output routines
+        string AsString(const char *format) { int128_t tmp; tmp.Lo=Lo; tmp.Hi=Hi; return tmp.AsString(format);}
+        char GetLowByte() {return Lo&0xFF;}
+//  protected:
+        // these operations are exported for higher level use
+        // they don't use the this variable...
+        static int SubDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B,const int borrow);
+        static int AddDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B,const int carry);
+        static BuiltinInt128_t DivideDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B);
+        static int64 DivideByLimb(BuiltinInt128_t *A,const int64 B,const int64 Remainder=0);
+        static int64 ModByLimb(const BuiltinInt128_t &A,const int64 B,const int64 Remainder=0);
+        static BuiltinInt128_t MultiplyDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B);
+        static BuiltinInt128_t SquareDouble(BuiltinInt128_t *A);
+        static void MultiplyLow(BuiltinInt128_t *A,const BuiltinInt128_t &B) { Set(A,Get(*A)*Get(B));}
+        static BuiltinInt128_t AddMulDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B,const BuiltinInt128_t &C);
+        static BuiltinInt128_t SubMulDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B,const BuiltinInt128_t &C);
+        static int64 AddMulLimb(BuiltinInt128_t *A,const BuiltinInt128_t &B,const int64 C);
+        static int64 SubMulLimb(BuiltinInt128_t *A,const BuiltinInt128_t &B,const int64 C);
+        static int shiftleft(BuiltinInt128_t *Value,const int Carry_prm);
+        static int shiftright(BuiltinInt128_t *Value,const int Carry_prm);
+        static int shiftleftn(BuiltinInt128_t *Value,const int Count);
+        static int shiftrightn(BuiltinInt128_t *Value,const int Count);
+        // flat access to the limbs, same as int128_t
+        static int64 *LimbPtr(BuiltinInt128_t *Value) { return &Value->Lo;}
+        static const int64 *LimbPtr(const BuiltinInt128_t &Value) { return &Value.Lo;}
+        static void GetLimbs(const BuiltinInt128_t &Value,int64 *Limbs) { Limbs[0]=Value.Lo; Limbs[1]=Value.Hi;}
+        static void SetLimbs(BuiltinInt128_t *Value,const int64 *Limbs) { Value->Lo=Limbs[0]; Value->Hi=Limbs[1];}
+        static constexpr BuiltinInt128_t FromLimbs(const int64 *Limbs) { BuiltinInt128_t ret; ret.Lo=Limbs[0]; ret.Hi=Limbs[1]; return ret;}
+        // the value as the compiler's own 128 bit type and back
+        static uint128 Get(const BuiltinInt128_t &Value) { return ((uint128)(uint64)Value.Hi<<64)|(uint64)Value.Lo;}
+        static void Set(BuiltinInt128_t *Value,const uint128 V) { Value->Lo=(int64)(uint64)V; Value->Hi=(int64)(uint64)(V>>64);}
+//  private:
+        int64 Lo;
+        int64 Hi;
+        static const int size=128;
+        static const int limbs=2;
+        static const int depth=0;
+};
+
+typedef class BuiltinInt128_t bint128;
+
+
+//
+//
+//          The BuiltinInt128_t methods
+//
+//
+//
+
+inline int BuiltinInt128_t::AddDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B,const int carry)
+{
+    uint64 c;
+    A->Lo=AddCarry64(A->Lo,B.Lo,carry,&c);
+    A->Hi=AddCarry64(A->Hi,B.Hi,c,&c);
+    return (int)c;
+}
+
+inline int BuiltinInt128_t::SubDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B,const int borrow)
+{
+    uint64 b;
+    A->Lo=SubBorrow64(A->Lo,B.Lo,borrow,&b);
+    A->Hi=SubBorrow64(A->Hi,B.Hi,b,&b);
+    return (int)b;
+}
+
+// the same grade school multiply as int128_t::MultiplyDouble, each 64x64
+// product is a uint128 and the columns are summed with the carry chains
+//   ab
+//*  cd
+//------
+// wxyz
+inline BuiltinInt128_t BuiltinInt128_t::MultiplyDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B)
+{
+    if (A==&B)
+    {
+        return SquareDouble(A);
+    }
+    BuiltinInt128_t ret;
+    uint64 a=A->Hi,b=A->Lo,c=B.Hi,d=B.Lo;
+    uint128 bd=(uint128)b*d;
+    uint128 ad=(uint128)a*d;
+    uint128 bc=(uint128)b*c;
+    uint128 ac=(uint128)a*c;
+    uint64 c1,c2,c3;
+    uint64 y=AddCarry64((uint64)(bd>>64),(uint64)ad,0,&c1);
+    uint64 x=AddCarry64((uint64)(ad>>64),(uint64)ac,c1,&c1);
+    y=AddCarry64(y,(uint64)bc,0,&c2);
+    x=AddCarry64(x,(uint64)(bc>>64),c2,&c2);
+    uint64 w=AddCarry64((uint64)(ac>>64),c1,c2,&c3);
+    A->Lo=(uint64)bd;
+    A->Hi=y;
+    ret.Lo=x;
+    ret.Hi=w;
+    return ret;
+}
+
+// the cross product once, doubled
+inline BuiltinInt128_t BuiltinInt128_t::SquareDouble(BuiltinInt128_t *A)
+{
+    BuiltinInt128_t ret;
+    uint64 a=A->Hi,b=A->Lo;
+    uint128 bb=(uint128)b*b;
+    uint128 ab=(uint128)a*b;
+    uint128 aa=(uint128)a*a;
+    uint64 mtop=(uint64)(ab>>127);
+    ab<<=1;
+    uint64 c;
+    uint64 y=AddCarry64((uint64)(bb>>64),(uint64)ab,0,&c);
+    uint64 x=AddCarry64((uint64)aa,(uint64)(ab>>64),c,&c);
+    uint64 w=AddCarry64((uint64)(aa>>64),mtop,c,&c);
+    A->Lo=(uint64)bb;
+    A->Hi=y;
+    ret.Lo=x;
+    ret.Hi=w;
+    return ret;
+}
+
+// (ret:A)=A+B*C
+inline BuiltinInt128_t BuiltinInt128_t::AddMulDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B,const BuiltinInt128_t &C)
+{
+    BuiltinInt128_t lo=B;
+    BuiltinInt128_t hi=MultiplyDouble(&lo,C);
+    int carry=AddDouble(&lo,*A,0);
+    Set(&hi,Get(hi)+carry);
+    *A=lo;
+    return hi;
+}
+
+// A-=B*C, returns what that borrowed from above
+inline BuiltinInt128_t BuiltinInt128_t::SubMulDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B,const BuiltinInt128_t &C)
+{
+    BuiltinInt128_t lo=B;
+    BuiltinInt128_t hi=MultiplyDouble(&lo,C);
+    int borrow=SubDouble(A,lo,0);
+    Set(&hi,Get(hi)+borrow);
+    return hi;
+}
+
+// A+=B*C for a single limb C, returns the limb carried out the top
+inline int64 BuiltinInt128_t::AddMulLimb(BuiltinInt128_t *A,const BuiltinInt128_t &B,const int64 C)
+{
+    uint128 lo=(uint128)(uint64)B.Lo*(uint64)C+(uint64)A->Lo;
+    uint128 hi=(uint128)(uint64)B.Hi*(uint64)C+(uint64)A->Hi+(uint64)(lo>>64);
+    A->Lo=(uint64)lo;
+    A->Hi=(uint64)hi;
+    return (uint64)(hi>>64);
+}
+
+// A-=B*C for a single limb C, returns the limb borrowed from above
+inline int64 BuiltinInt128_t::SubMulLimb(BuiltinInt128_t *A,const BuiltinInt128_t &B,const int64 C)
+{
+    uint128 lo=(uint128)(uint64)B.Lo*(uint64)C;
+    uint128 hi=(uint128)(uint64)B.Hi*(uint64)C+(uint64)(lo>>64);
+    uint64 borrow;
+    A->Lo=SubBorrow64(A->Lo,(uint64)lo,0,&borrow);
+    A->Hi=SubBorrow64(A->Hi,(uint64)hi,borrow,&borrow);
+    return (uint64)(hi>>64)+borrow;
+}
+
+// A=(Remainder:A)/B returns the remainder, Remainder must be less than B.
+// Each step is a 128/64 divide, which the compiler may do with a library call.
+inline int64 BuiltinInt128_t::DivideByLimb(BuiltinInt128_t *A,const int64 B,const int64 Remainder)
+{
+    if (B==0)
+    {
+        throw "Divide by zero";
+    }
+    uint64 divisor=B;
+    uint128 top=((uint128)(uint64)Remainder<<64)|(uint64)A->Hi;
+    A->Hi=(uint64)(top/divisor);
+    uint128 bottom=((uint128)(uint64)(top%divisor)<<64)|(uint64)A->Lo;
+    A->Lo=(uint64)(bottom/divisor);
+    return (uint64)(bottom%divisor);
+}
+
+inline int64 BuiltinInt128_t::ModByLimb(const BuiltinInt128_t &A,const int64 B,const int64 Remainder)
+{
+    BuiltinInt128_t tmp=A;
+    return DivideByLimb(&tmp,B,Remainder);
+}
+
+// A=A/B Ret=Remainder
+inline BuiltinInt128_t BuiltinInt128_t::DivideDouble(BuiltinInt128_t *A,const BuiltinInt128_t &B)
+{
+    uint128 b=Get(B);
+    if (b==0)
+    {
+        throw "division by zero";
+    }
+    BuiltinInt128_t remainder;
+    uint128 a=Get(*A);
+    Set(A,a/b);
+    Set(&remainder,a%b);
+    return remainder;
+}
+
+// one bit shifts with a carry in, returns the bit shifted out
+inline int BuiltinInt128_t::shiftleft(BuiltinInt128_t *Value,const int Carry_prm)
+{
+    uint128 v=Get(*Value);
+    int carry_ret=(int)(v>>127);
+    Set(Value,(v<<1)|(Carry_prm!=0));
+    return carry_ret;
+}
+
+inline int BuiltinInt128_t::shiftright(BuiltinInt128_t *Value,const int Carry_prm)
+{
+    uint128 v=Get(*Value);
+    int carry_ret=(int)(v&1);
+    Set(Value,(v>>1)|((uint128)(Carry_prm!=0)<<127));
+    return carry_ret;
+}
+
+// multi bit shifts, returns the last bit shifted out
+inline int BuiltinInt128_t::shiftleftn(BuiltinInt128_t *Value,const int Count)
+{
+    if (Count<=0)
+    {
+        return 0;
+    }
+    uint128 v=Get(*Value);
+    if (Count>128)
+    {
+        Set(Value,0);
+        return 0;
+    }
+    int carry_ret=(int)((v>>(128-Count))&1);
+    Set(Value,(Count==128)?0:v<<Count);
+    return carry_ret;
+}
+
+inline int BuiltinInt128_t::shiftrightn(BuiltinInt128_t *Value,const int Count)
+{
+    if (Count<=0)
+    {
+        return 0;
+    }
+    uint128 v=Get(*Value);
+    if (Count>128)
+    {
+        Set(Value,0);
+        return 0;
+    }
+    int carry_ret=(int)((v>>(Count-1))&1);
+    Set(Value,(Count==128)?0:v>>Count);
+    return carry_ret;
+}
+
+#endif //BUILTININT128_T_HPP
@@ -67,8 +67,45 @@
 #ifndef DOUBLEINT_T_HPP
 #define DOUBLEINT_T_HPP
 
+#include <type_traits>
+#include <utility>
 #include "int128_t.hpp"
-
+#include "FastMultiply.hpp"
+#include "FastDivide.hpp"
+#include "SmallKernels.hpp"
+#include "FixedInt_t.hpp"
+#include "BuiltinInt128_t.hpp"
+#include "HeapInt_t.hpp"
+
+// Nesting depth (int256=1, int512=2, int1024=3...) at which MultiplyDouble
+// switches from the 4 multiply schoolbook method to Karatsuba. Below this the 
+// extra adds/subtracts cost more than the multiply they save.
+#ifndef DOUBLEINT_KARATSUBA_DEPTH
+#define DOUBLEINT_KARATSUBA_DEPTH 4
+#endif
+
+// MultiplyDouble of types between these widths (in bits) that aren't using
+// Karatsuba is a single Comba multiply (see FastMultiply.hpp) rather than
+// four half width ones. int512 and below have their own kernels.
+#ifndef DOUBLEINT_COMBA_MIN_BITS
+#define DOUBLEINT_COMBA_MIN_BITS 1024
+#endif
+#ifndef DOUBLEINT_COMBA_BITS
+#define DOUBLEINT_COMBA_BITS 2048
+#endif
+
+// Types this wide (in bits) or wider don't recurse at all, MultiplyDouble 
+// flattens the operands and hands them to the Toom-3/NTT code in FastMultiply.hpp
+#ifndef DOUBLEINT_FLAT_MULTIPLY_BITS
+#define DOUBLEINT_FLAT_MULTIPLY_BITS 8192
+#endif
+
+// WideMultiply of two values this wide (in bits) or wider goes straight to the
+// flat multiply, below it the nested MultiplyDouble is quicker. Squares stay
+// nested one size longer.
+#ifndef DOUBLEINT_WIDE_FLAT_BITS
+#define DOUBLEINT_WIDE_FLAT_BITS 512
+#endif
 
 // This is the core doubler template. It takes either itself or the int128_t
 // Class and creates a class which has exactly 2x the number of bits. This allows us 
@@ -78,12 +115,15 @@ template<class BaseIntT> class DoubleInt_t
 {
     public:
         // construction/casting
-        DoubleInt_t()                    :Hi(0),Lo(0),size(Hi.size*2) {}
-        DoubleInt_t(const DoubleInt_t &orig):Hi(orig.Hi),Lo(orig.Lo),size(Hi.size*2) {}
-        DoubleInt_t(const BaseIntT    &orig):Hi(0),Lo(orig),size(Hi.size*2) {}
-        DoubleInt_t(const int64       &orig):Hi(0),Lo(orig),size(Hi.size*2) {}
+        DoubleInt_t()                    :Lo(0),Hi(0) { static_assert((sizeof(DoubleInt_t)==size/8) && std::is_trivially_copyable<DoubleInt_t>::value,"DoubleInt_t should just be its limbs");}
+        DoubleInt_t(const DoubleInt_t &orig)=default;
+        constexpr DoubleInt_t(const BaseIntT    &orig):Lo(orig),Hi(0) {}
+        constexpr DoubleInt_t(const int64       &orig):Lo(orig),Hi(0) {}
+        // from the two halves. The default constructor isn't constexpr on
+        // purpose, gcc then tries to fold every int1MB x; which takes forever.
+        constexpr DoubleInt_t(const BaseIntT &lo,const BaseIntT &hi):Lo(lo),Hi(hi) {}
         // assignment
-        DoubleInt_t &operator= (const DoubleInt_t &rhs) {Hi=rhs.Hi;Lo=rhs.Lo;return *this;}
+        DoubleInt_t &operator= (const DoubleInt_t &rhs)=default;
         // compariston
         bool     operator==(const DoubleInt_t &rhs) { if ((Hi==rhs.Hi) && (Lo==rhs.Lo)) return true; return false;}
         bool     operator!=(const DoubleInt_t &rhs) { if ((Hi==rhs.Hi) && (Lo==rhs.Lo)) return false; return true;}
@@ -92,11 +132,11 @@ template<class BaseIntT> class DoubleInt_t
         bool     operator> (const DoubleInt_t &rhs) { if ((Hi>rhs.Hi) || ( (Hi==rhs.Hi) && (Lo>rhs.Lo ))) return true; return false;}
         bool     operator< (const DoubleInt_t &rhs) { if ((Hi<rhs.Hi) || ( (Hi==rhs.Hi) && (Lo<rhs.Lo ))) return true; return false;}
         // operations (these are exported for user use)
-        DoubleInt_t &operator>>=(const int      rhs)  { for (int x=0;x<rhs;x++) shiftright(this,0); return *this;}
-        DoubleInt_t &operator<<=(const int      rhs)  { for (int x=0;x<rhs;x++) shiftleft(this,0); return *this;}
+        DoubleInt_t &operator>>=(const int      rhs)  { shiftrightn(this,rhs); return *this;}
+        DoubleInt_t &operator<<=(const int      rhs)  { shiftleftn(this,rhs); return *this;}
         DoubleInt_t &operator-=( const DoubleInt_t &rhs) { SubDouble(this,rhs,0); return *this;}
         DoubleInt_t &operator+=( const DoubleInt_t &rhs) { AddDouble(this,rhs,0); return *this;}
-        DoubleInt_t &operator*=( const DoubleInt_t &rhs) { MultiplyDouble(this,rhs); return *this;}
+        DoubleInt_t &operator*=( const DoubleInt_t &rhs) { MultiplyLow(this,rhs); return *this;}
         DoubleInt_t &operator/=( const DoubleInt_t &rhs) { DivideDouble(this,rhs); return *this;}
         DoubleInt_t &operator%=( const DoubleInt_t &rhs) { *this=DivideDouble(this,rhs); return *this;}
 
@@ -111,19 +151,100 @@ template<class BaseIntT> class DoubleInt_t
         DoubleInt_t &operator^=( const DoubleInt_t &rhs) { this->Lo^=rhs.Lo; this->Hi^=rhs.Hi; return *this;}
 
 
-        DoubleInt_t operator+(   const DoubleInt_t &rhs) { DoubleInt_t tmp=*this; AddDouble(&tmp,rhs,0); return tmp;}
-        DoubleInt_t operator-(   const DoubleInt_t &rhs) { DoubleInt_t tmp=*this; SubDouble(&tmp,rhs,0); return tmp;}
-        DoubleInt_t operator/(   const DoubleInt_t &rhs) { DoubleInt_t tmp=*this; DivideDouble(&tmp,rhs); return tmp;}
-        DoubleInt_t operator%(   const DoubleInt_t &rhs) { DoubleInt_t tmp=*this; tmp=DivideDouble(&tmp,rhs); return tmp;}
-        DoubleInt_t operator*(   const DoubleInt_t &rhs) { DoubleInt_t tmp=*this; MultiplyDouble(&tmp,rhs); return tmp;}
-
-        DoubleInt_t operator&(   const int64    &rhs) { DoubleInt_t tmp=*this; tmp.Lo&=rhs; return tmp;}
-        DoubleInt_t operator|(   const int64    &rhs) { DoubleInt_t tmp=*this; tmp.Lo|=rhs; return tmp;}
-        DoubleInt_t operator^(   const int64    &rhs) { DoubleInt_t tmp=*this; tmp.Lo^=rhs; return tmp;}
-
-
-        DoubleInt_t operator>>(  const int      &rhs) { DoubleInt_t tmp=*this; tmp>>=rhs; return tmp;}
-        DoubleInt_t operator<<(  const int      &rhs) { DoubleInt_t tmp=*this; tmp<<=rhs; return tmp;}
+        DoubleInt_t operator+(   const DoubleInt_t &rhs) & { DoubleInt_t tmp=*this; AddDouble(&tmp,rhs,0); return tmp;}
+        DoubleInt_t operator-(   const DoubleInt_t &rhs) & { DoubleInt_t tmp=*this; SubDouble(&tmp,rhs,0); return tmp;}
+        DoubleInt_t operator/(   const DoubleInt_t &rhs) & { DoubleInt_t tmp=*this; DivideDouble(&tmp,rhs); return tmp;}
+        DoubleInt_t operator%(   const DoubleInt_t &rhs) & { DoubleInt_t tmp=*this; tmp=DivideDouble(&tmp,rhs); return tmp;}
+        DoubleInt_t operator*(   const DoubleInt_t &rhs) & { DoubleInt_t tmp=*this; MultiplyLow(&tmp,rhs); return tmp;}
+        DoubleInt_t Square() { DoubleInt_t tmp=*this; SquareDouble(&tmp); return tmp;}
+
+        DoubleInt_t operator&(   const int64    &rhs) & { DoubleInt_t tmp=*this; tmp.Lo&=rhs; return tmp;}
+        DoubleInt_t operator|(   const int64    &rhs) & { DoubleInt_t tmp=*this; tmp.Lo|=rhs; return tmp;}
+        DoubleInt_t operator^(   const int64    &rhs) & { DoubleInt_t tmp=*this; tmp.Lo^=rhs; return tmp;}
+
+
+        DoubleInt_t operator>>(  const int      &rhs) & { DoubleInt_t tmp=*this; tmp>>=rhs; return tmp;}
+        DoubleInt_t operator<<(  const int      &rhs) & { DoubleInt_t tmp=*this; tmp<<=rhs; return tmp;}
+
+        // A temporary (the result of another operator usually) is worked on in
+        // place and moved along, so a*b+c*d-e only makes the two products. They
+        // still return by value, so const T &r=a*b+c; keeps the result alive
+        // like it would for any other expression.
+        DoubleInt_t operator+(   const DoubleInt_t &rhs) && { AddDouble(this,rhs,0); return std::move(*this);}
+        DoubleInt_t operator-(   const DoubleInt_t &rhs) && { SubDouble(this,rhs,0); return std::move(*this);}
+        DoubleInt_t operator/(   const DoubleInt_t &rhs) && { DivideDouble(this,rhs); return std::move(*this);}
+        DoubleInt_t operator%(   const DoubleInt_t &rhs) && { *this=DivideDouble(this,rhs); return std::move(*this);}
+        DoubleInt_t operator*(   const DoubleInt_t &rhs) && { MultiplyLow(this,rhs); return std::move(*this);}
+
+        DoubleInt_t operator&(   const int64    &rhs) && { Lo&=rhs; return std::move(*this);}
+        DoubleInt_t operator|(   const int64    &rhs) && { Lo|=rhs; return std::move(*this);}
+        DoubleInt_t operator^(   const int64    &rhs) && { Lo^=rhs; return std::move(*this);}
+
+        DoubleInt_t operator>>(  const int      &rhs) && { *this>>=rhs; return std::move(*this);}
+        DoubleInt_t operator<<(  const int      &rhs) && { *this<<=rhs; return std::move(*this);}
+
+        // a+b*c and a*(b+c), here the right hand side is the temporary
+        friend DoubleInt_t operator+(DoubleInt_t &lhs,DoubleInt_t &&rhs) { AddDouble(&rhs,lhs,0); return std::move(rhs);}
+        friend DoubleInt_t operator*(DoubleInt_t &lhs,DoubleInt_t &&rhs) { MultiplyLow(&rhs,lhs); return std::move(rhs);}
+
+        // Mixed width, the other side is an int64 or a narrower flat integer
+        // (int128, a smaller DoubleInt_t or FixedInt_t). Only the limbs it
+        // covers are worked on, a carry goes up only as far as it ripples and
+        // the multiply only forms the rows that land in the result, so x+=1 on
+        // an int4096 is one add rather than 64 of them.
+        template<class NarrowT> using IfNarrow_t=typename std::enable_if<(NarrowT::limbs<BaseIntT::limbs*2) && (sizeof(NarrowT)==NarrowT::limbs*sizeof(int64)),int>::type;
+
+        bool     operator==(const int64    &rhs) { return CompareLimbsShort(LimbPtr(*this),limbs,&rhs,1)==0;}
+        bool     operator!=(const int64    &rhs) { return CompareLimbsShort(LimbPtr(*this),limbs,&rhs,1)!=0;}
+        bool     operator>=(const int64    &rhs) { return CompareLimbsShort(LimbPtr(*this),limbs,&rhs,1)>=0;}
+        bool     operator<=(const int64    &rhs) { return CompareLimbsShort(LimbPtr(*this),limbs,&rhs,1)<=0;}
+        bool     operator> (const int64    &rhs) { return CompareLimbsShort(LimbPtr(*this),limbs,&rhs,1)>0;}
+        bool     operator< (const int64    &rhs) { return CompareLimbsShort(LimbPtr(*this),limbs,&rhs,1)<0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator==(const NarrowT &rhs) { return CompareNarrow(*this,rhs)==0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator!=(const NarrowT &rhs) { return CompareNarrow(*this,rhs)!=0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator>=(const NarrowT &rhs) { return CompareNarrow(*this,rhs)>=0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator<=(const NarrowT &rhs) { return CompareNarrow(*this,rhs)<=0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator> (const NarrowT &rhs) { return CompareNarrow(*this,rhs)>0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator< (const NarrowT &rhs) { return CompareNarrow(*this,rhs)<0;}
+
+        DoubleInt_t &operator+=( const int64    &rhs) { AddLimbsShort(LimbPtr(this),limbs,&rhs,1); return *this;}
+        DoubleInt_t &operator-=( const int64    &rhs) { SubLimbsShort(LimbPtr(this),limbs,&rhs,1); return *this;}
+        DoubleInt_t &operator*=( const int64    &rhs) { MultiplyLimbsShort(LimbPtr(this),limbs,&rhs,1); return *this;}
+        DoubleInt_t &operator/=( const int64    &rhs) { DivideByLimb(this,rhs); return *this;}
+        DoubleInt_t &operator%=( const int64    &rhs) { *this=DoubleInt_t(ModByLimb(*this,rhs)); return *this;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t &operator+=(const NarrowT &rhs) { AddLimbsShort(LimbPtr(this),limbs,NarrowT::LimbPtr(rhs),NarrowT::limbs); return *this;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t &operator-=(const NarrowT &rhs) { SubLimbsShort(LimbPtr(this),limbs,NarrowT::LimbPtr(rhs),NarrowT::limbs); return *this;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t &operator*=(const NarrowT &rhs) { MultiplyLimbsShort(LimbPtr(this),limbs,NarrowT::LimbPtr(rhs),NarrowT::limbs); return *this;}
+        // the long divide already skips the zero top limbs of the divisor
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t &operator/=(const NarrowT &rhs) { DivideDouble(this,Widen(rhs)); return *this;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t &operator%=(const NarrowT &rhs) { *this=DivideDouble(this,Widen(rhs)); return *this;}
+
+        DoubleInt_t operator+(   const int64    &rhs) & { DoubleInt_t tmp=*this; tmp+=rhs; return tmp;}
+        DoubleInt_t operator-(   const int64    &rhs) & { DoubleInt_t tmp=*this; tmp-=rhs; return tmp;}
+        DoubleInt_t operator*(   const int64    &rhs) & { DoubleInt_t tmp=*this; tmp*=rhs; return tmp;}
+        DoubleInt_t operator/(   const int64    &rhs) & { DoubleInt_t tmp=*this; tmp/=rhs; return tmp;}
+        DoubleInt_t operator%(   const int64    &rhs) & { return DoubleInt_t(ModByLimb(*this,rhs));}
+        DoubleInt_t operator+(   const int64    &rhs) && { *this+=rhs; return std::move(*this);}
+        DoubleInt_t operator-(   const int64    &rhs) && { *this-=rhs; return std::move(*this);}
+        DoubleInt_t operator*(   const int64    &rhs) && { *this*=rhs; return std::move(*this);}
+        DoubleInt_t operator/(   const int64    &rhs) && { *this/=rhs; return std::move(*this);}
+        DoubleInt_t operator%(   const int64    &rhs) && { *this%=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator+(const NarrowT &rhs) & { DoubleInt_t tmp=*this; tmp+=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator-(const NarrowT &rhs) & { DoubleInt_t tmp=*this; tmp-=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator*(const NarrowT &rhs) & { DoubleInt_t tmp=*this; tmp*=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator/(const NarrowT &rhs) & { DoubleInt_t tmp=*this; tmp/=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator%(const NarrowT &rhs) & { DoubleInt_t tmp=*this; tmp%=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator+(const NarrowT &rhs) && { *this+=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator-(const NarrowT &rhs) && { *this-=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator*(const NarrowT &rhs) && { *this*=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator/(const NarrowT &rhs) && { *this/=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> DoubleInt_t operator%(const NarrowT &rhs) && { *this%=rhs; return std::move(*this);}
+
+        // and 1+x, 3*x the other way around
+        friend DoubleInt_t operator+(const int64 &lhs,DoubleInt_t rhs) { rhs+=lhs; return rhs;}
+        friend DoubleInt_t operator*(const int64 &lhs,DoubleInt_t rhs) { rhs*=lhs; return rhs;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> friend DoubleInt_t operator+(const NarrowT &lhs,DoubleInt_t rhs) { rhs+=lhs; return rhs;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> friend DoubleInt_t operator*(const NarrowT &lhs,DoubleInt_t rhs) { rhs*=lhs; return rhs;}
 
 
 
@@ -137,13 +258,43 @@ template<class BaseIntT> class DoubleInt_t
         static int SubDouble(DoubleInt_t *A,const DoubleInt_t &B,const int borrow);     
         static int AddDouble(DoubleInt_t *A,const DoubleInt_t &B,const int carry);
         static DoubleInt_t DivideDouble(DoubleInt_t *A,const DoubleInt_t &B);
+        static int64 DivideByLimb(DoubleInt_t *A,const int64 B,const int64 Remainder=0) { int64 r=BaseIntT::DivideByLimb(&A->Hi,B,Remainder); return BaseIntT::DivideByLimb(&A->Lo,B,r);}
+        static int64 ModByLimb(const DoubleInt_t &A,const int64 B,const int64 Remainder=0) { int64 r=BaseIntT::ModByLimb(A.Hi,B,Remainder); return BaseIntT::ModByLimb(A.Lo,B,r);}
         static DoubleInt_t MultiplyDouble(DoubleInt_t *A,const DoubleInt_t &B);
+        static DoubleInt_t SquareDouble(DoubleInt_t *A);
+        static DoubleInt_t SquareKaratsuba(DoubleInt_t *A);
+        static void MultiplyLow(DoubleInt_t *A,const DoubleInt_t &B);
+        static DoubleInt_t MultiplyKaratsuba(DoubleInt_t *A,const DoubleInt_t &B);
+        static DoubleInt_t MultiplyFlat(DoubleInt_t *A,const DoubleInt_t &B);
+        static DoubleInt_t MultiplyComba(DoubleInt_t *A,const DoubleInt_t &B);
+        // acc+=a*b in one pass (see AddMulLimbs), the high half or the borrow
+        // from above is returned like MultiplyDouble does
+        static DoubleInt_t AddMulDouble(DoubleInt_t *A,const DoubleInt_t &B,const DoubleInt_t &C);
+        static DoubleInt_t SubMulDouble(DoubleInt_t *A,const DoubleInt_t &B,const DoubleInt_t &C);
+        static int64 AddMulLimb(DoubleInt_t *A,const DoubleInt_t &B,const int64 C) { return ::AddMulLimb(LimbPtr(A),LimbPtr(B),limbs,C);}
+        static int64 SubMulLimb(DoubleInt_t *A,const DoubleInt_t &B,const int64 C) { return ::SubMulLimb(LimbPtr(A),LimbPtr(B),limbs,C);}
         static int shiftleft(DoubleInt_t *Value,const int Carry_prm);
         static int shiftright(DoubleInt_t *Value,const int Carry_prm);
+        static int shiftleftn(DoubleInt_t *Value,const int Count);
+        static int shiftrightn(DoubleInt_t *Value,const int Count);
+        // flat access to the limbs, least significant limb first. Lo comes
+        // before Hi at every level so the value already is that array, LimbPtr
+        // lets the flat kernels work on it where it sits.
+        static int64 *LimbPtr(DoubleInt_t *Value) { return (int64 *)Value;}
+        static const int64 *LimbPtr(const DoubleInt_t &Value) { return (const int64 *)&Value;}
+        static void GetLimbs(const DoubleInt_t &Value,int64 *Limbs) { for (int x=0;x<limbs;x++) Limbs[x]=LimbPtr(Value)[x];}
+        static void SetLimbs(DoubleInt_t *Value,const int64 *Limbs) { for (int x=0;x<limbs;x++) LimbPtr(Value)[x]=Limbs[x];}
+        // SetLimbs that can run at compile time (no casting the pointer), see ConstFromString
+        static constexpr DoubleInt_t FromLimbs(const int64 *Limbs) { return DoubleInt_t(BaseIntT::FromLimbs(Limbs),BaseIntT::FromLimbs(&Limbs[BaseIntT::limbs]));}
+        // a narrower value zero extended, and compared without extending it
+        template<class NarrowT> static DoubleInt_t Widen(const NarrowT &Value) { DoubleInt_t ret; for (int x=0;x<NarrowT::limbs;x++) LimbPtr(&ret)[x]=NarrowT::LimbPtr(Value)[x]; return ret;}
+        template<class NarrowT> static int CompareNarrow(const DoubleInt_t &A,const NarrowT &B) { return CompareLimbsShort(LimbPtr(A),limbs,NarrowT::LimbPtr(B),NarrowT::limbs);}
 //  private:
-        BaseIntT Hi;
         BaseIntT Lo;
-        const int size;
+        BaseIntT Hi;
+        static const int size=BaseIntT::size*2; //bits, kept out of the object so arrays of these pack densely
+        static const int limbs=BaseIntT::limbs*2;
+        static const int depth=BaseIntT::depth+1;
 };
 
 // throw exceptions on overflow/underflow etc..
@@ -185,8 +336,10 @@ template<class BaseIntT> class SignedInt_t
         SignedInt_t &operator<<=(const int      rhs)  { Value<<=rhs; return *this;}
         SignedInt_t &operator-=( const SignedInt_t &rhs) { SubDouble(this,rhs,0);  return *this;}
         SignedInt_t &operator+=( const SignedInt_t &rhs) { AddDouble(this,rhs,0); return *this;}
-        SignedInt_t &operator*=( const SignedInt_t &rhs) { MultiplyDouble(this,rhs); return *this;}
+        SignedInt_t &operator*=( const SignedInt_t &rhs) { MultiplyLow(this,rhs); return *this;}
         SignedInt_t &operator/=( const SignedInt_t &rhs) { DivideDouble(this,rhs); return *this;}
+        // the remainder takes the sign of the dividend, like C
+        SignedInt_t &operator%=( const SignedInt_t &rhs) { int negative=Negative; Value=BaseIntT::DivideDouble(&Value,rhs.Value); Negative=(Value==0)?0:negative; return *this;}
 
 
         SignedInt_t &operator&=( const int64 &rhs) { Value&=rhs; return *this;}
@@ -198,18 +351,92 @@ template<class BaseIntT> class SignedInt_t
         SignedInt_t &operator^=( const SignedInt_t &rhs) { Value^=rhs.Value; return *this;}
 
 
-        SignedInt_t operator+(   const SignedInt_t &rhs) { SignedInt_t tmp=*this; AddDouble(&tmp,rhs,0); return tmp;}
-        SignedInt_t operator-(   const SignedInt_t &rhs) { SignedInt_t tmp=*this; SubDouble(&tmp,rhs,0); return tmp;}
-        SignedInt_t operator/(   const SignedInt_t &rhs) { SignedInt_t tmp=*this; DivideDouble(&tmp,rhs); return tmp;}
-        SignedInt_t operator*(   const SignedInt_t &rhs) { SignedInt_t tmp=*this; MultiplyDouble(&tmp,rhs); return tmp;}
-
-        SignedInt_t operator&(   const int64    &rhs) { SignedInt_t tmp=*this; tmp.Value&=rhs; return tmp;}
-        SignedInt_t operator|(   const int64    &rhs) { SignedInt_t tmp=*this; tmp.Value|=rhs; return tmp;}
-        SignedInt_t operator^(   const int64    &rhs) { SignedInt_t tmp=*this; tmp.Value^=rhs; return tmp;}
-
-
-        SignedInt_t operator>>(  const int      &rhs) { SignedInt_t tmp=*this; tmp>>=rhs; return tmp;}
-        SignedInt_t operator<<(  const int      &rhs) { SignedInt_t tmp=*this; tmp<<=rhs; return tmp;}
+        SignedInt_t operator+(   const SignedInt_t &rhs) & { SignedInt_t tmp=*this; AddDouble(&tmp,rhs,0); return tmp;}
+        SignedInt_t operator-(   const SignedInt_t &rhs) & { SignedInt_t tmp=*this; SubDouble(&tmp,rhs,0); return tmp;}
+        SignedInt_t operator/(   const SignedInt_t &rhs) & { SignedInt_t tmp=*this; DivideDouble(&tmp,rhs); return tmp;}
+        SignedInt_t operator*(   const SignedInt_t &rhs) & { SignedInt_t tmp=*this; MultiplyLow(&tmp,rhs); return tmp;}
+        SignedInt_t operator%(   const SignedInt_t &rhs) & { SignedInt_t tmp=*this; tmp%=rhs; return tmp;}
+        SignedInt_t Square() { SignedInt_t tmp=*this; SquareDouble(&tmp); return tmp;}
+
+        SignedInt_t operator&(   const int64    &rhs) & { SignedInt_t tmp=*this; tmp.Value&=rhs; return tmp;}
+        SignedInt_t operator|(   const int64    &rhs) & { SignedInt_t tmp=*this; tmp.Value|=rhs; return tmp;}
+        SignedInt_t operator^(   const int64    &rhs) & { SignedInt_t tmp=*this; tmp.Value^=rhs; return tmp;}
+
+
+        SignedInt_t operator>>(  const int      &rhs) & { SignedInt_t tmp=*this; tmp>>=rhs; return tmp;}
+        SignedInt_t operator<<(  const int      &rhs) & { SignedInt_t tmp=*this; tmp<<=rhs; return tmp;}
+
+        // temporaries are worked on in place, see DoubleInt_t
+        SignedInt_t operator+(   const SignedInt_t &rhs) && { AddDouble(this,rhs,0); return std::move(*this);}
+        SignedInt_t operator-(   const SignedInt_t &rhs) && { SubDouble(this,rhs,0); return std::move(*this);}
+        SignedInt_t operator/(   const SignedInt_t &rhs) && { DivideDouble(this,rhs); return std::move(*this);}
+        SignedInt_t operator*(   const SignedInt_t &rhs) && { MultiplyLow(this,rhs); return std::move(*this);}
+        SignedInt_t operator%(   const SignedInt_t &rhs) && { *this%=rhs; return std::move(*this);}
+
+        SignedInt_t operator&(   const int64    &rhs) && { Value&=rhs; return std::move(*this);}
+        SignedInt_t operator|(   const int64    &rhs) && { Value|=rhs; return std::move(*this);}
+        SignedInt_t operator^(   const int64    &rhs) && { Value^=rhs; return std::move(*this);}
+
+        SignedInt_t operator>>(  const int      &rhs) && { *this>>=rhs; return std::move(*this);}
+        SignedInt_t operator<<(  const int      &rhs) && { *this<<=rhs; return std::move(*this);}
+
+        // a+b*c and a*(b+c), here the right hand side is the temporary
+        friend SignedInt_t operator+(SignedInt_t &lhs,SignedInt_t &&rhs) { AddDouble(&rhs,lhs,0); return std::move(rhs);}
+        friend SignedInt_t operator*(SignedInt_t &lhs,SignedInt_t &&rhs) { MultiplyLow(&rhs,lhs); return std::move(rhs);}
+
+        // Mixed width, see DoubleInt_t. An int64 keeps its sign, the narrower
+        // unsigned classes (up to the width of BaseIntT) are positive.
+        template<class NarrowT> using IfNarrow_t=typename std::enable_if<(NarrowT::limbs<=BaseIntT::limbs) && (sizeof(NarrowT)==NarrowT::limbs*sizeof(int64)),int>::type;
+
+        bool     operator==(const int64    &rhs) { return Compare64(*this,rhs)==0;}
+        bool     operator!=(const int64    &rhs) { return Compare64(*this,rhs)!=0;}
+        bool     operator>=(const int64    &rhs) { return Compare64(*this,rhs)>=0;}
+        bool     operator<=(const int64    &rhs) { return Compare64(*this,rhs)<=0;}
+        bool     operator> (const int64    &rhs) { return Compare64(*this,rhs)>0;}
+        bool     operator< (const int64    &rhs) { return Compare64(*this,rhs)<0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator==(const NarrowT &rhs) { return CompareShort(*this,NarrowT::LimbPtr(rhs),NarrowT::limbs,0)==0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator!=(const NarrowT &rhs) { return CompareShort(*this,NarrowT::LimbPtr(rhs),NarrowT::limbs,0)!=0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator>=(const NarrowT &rhs) { return CompareShort(*this,NarrowT::LimbPtr(rhs),NarrowT::limbs,0)>=0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator<=(const NarrowT &rhs) { return CompareShort(*this,NarrowT::LimbPtr(rhs),NarrowT::limbs,0)<=0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator> (const NarrowT &rhs) { return CompareShort(*this,NarrowT::LimbPtr(rhs),NarrowT::limbs,0)>0;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> bool operator< (const NarrowT &rhs) { return CompareShort(*this,NarrowT::LimbPtr(rhs),NarrowT::limbs,0)<0;}
+
+        SignedInt_t &operator+=( const int64    &rhs) { int64 b=Magnitude(rhs); AddShort(this,&b,1,rhs<0); return *this;}
+        SignedInt_t &operator-=( const int64    &rhs) { int64 b=Magnitude(rhs); AddShort(this,&b,1,rhs>=0); return *this;}
+        SignedInt_t &operator*=( const int64    &rhs) { int64 b=Magnitude(rhs); MultiplyShort(this,&b,1,rhs<0); return *this;}
+        SignedInt_t &operator/=( const int64    &rhs) { BaseIntT::DivideByLimb(&Value,Magnitude(rhs)); Negative=(Value==0)?0:Negative^(rhs<0); return *this;}
+        SignedInt_t &operator%=( const int64    &rhs) { Value=BaseIntT(BaseIntT::ModByLimb(Value,Magnitude(rhs))); Negative=(Value==0)?0:Negative; return *this;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t &operator+=(const NarrowT &rhs) { AddShort(this,NarrowT::LimbPtr(rhs),NarrowT::limbs,0); return *this;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t &operator-=(const NarrowT &rhs) { AddShort(this,NarrowT::LimbPtr(rhs),NarrowT::limbs,1); return *this;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t &operator*=(const NarrowT &rhs) { MultiplyShort(this,NarrowT::LimbPtr(rhs),NarrowT::limbs,0); return *this;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t &operator/=(const NarrowT &rhs) { DivideDouble(this,SignedInt_t(Widen(rhs))); return *this;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t &operator%=(const NarrowT &rhs) { *this%=SignedInt_t(Widen(rhs)); return *this;}
+
+        SignedInt_t operator+(   const int64    &rhs) & { SignedInt_t tmp=*this; tmp+=rhs; return tmp;}
+        SignedInt_t operator-(   const int64    &rhs) & { SignedInt_t tmp=*this; tmp-=rhs; return tmp;}
+        SignedInt_t operator*(   const int64    &rhs) & { SignedInt_t tmp=*this; tmp*=rhs; return tmp;}
+        SignedInt_t operator/(   const int64    &rhs) & { SignedInt_t tmp=*this; tmp/=rhs; return tmp;}
+        SignedInt_t operator%(   const int64    &rhs) & { SignedInt_t tmp=*this; tmp%=rhs; return tmp;}
+        SignedInt_t operator+(   const int64    &rhs) && { *this+=rhs; return std::move(*this);}
+        SignedInt_t operator-(   const int64    &rhs) && { *this-=rhs; return std::move(*this);}
+        SignedInt_t operator*(   const int64    &rhs) && { *this*=rhs; return std::move(*this);}
+        SignedInt_t operator/(   const int64    &rhs) && { *this/=rhs; return std::move(*this);}
+        SignedInt_t operator%(   const int64    &rhs) && { *this%=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator+(const NarrowT &rhs) & { SignedInt_t tmp=*this; tmp+=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator-(const NarrowT &rhs) & { SignedInt_t tmp=*this; tmp-=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator*(const NarrowT &rhs) & { SignedInt_t tmp=*this; tmp*=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator/(const NarrowT &rhs) & { SignedInt_t tmp=*this; tmp/=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator%(const NarrowT &rhs) & { SignedInt_t tmp=*this; tmp%=rhs; return tmp;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator+(const NarrowT &rhs) && { *this+=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator-(const NarrowT &rhs) && { *this-=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator*(const NarrowT &rhs) && { *this*=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator/(const NarrowT &rhs) && { *this/=rhs; return std::move(*this);}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> SignedInt_t operator%(const NarrowT &rhs) && { *this%=rhs; return std::move(*this);}
+
+        friend SignedInt_t operator+(const int64 &lhs,SignedInt_t rhs) { rhs+=lhs; return rhs;}
+        friend SignedInt_t operator*(const int64 &lhs,SignedInt_t rhs) { rhs*=lhs; return rhs;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> friend SignedInt_t operator+(const NarrowT &lhs,SignedInt_t rhs) { rhs+=lhs; return rhs;}
+        template<class NarrowT,IfNarrow_t<NarrowT> =0> friend SignedInt_t operator*(const NarrowT &lhs,SignedInt_t rhs) { rhs*=lhs; return rhs;}
 
         // the following pretty much the same as above, in both cases we are in temp hell
 
@@ -226,8 +453,17 @@ template<class BaseIntT> class SignedInt_t
         static int AddDouble(SignedInt_t *A,const SignedInt_t &B,const int carry);
         static SignedInt_t DivideDouble(SignedInt_t *A,const SignedInt_t &B);
         static SignedInt_t MultiplyDouble(SignedInt_t *A,const SignedInt_t &B);
+        static SignedInt_t SquareDouble(SignedInt_t *A);
+        static void MultiplyLow(SignedInt_t *A,const SignedInt_t &B);
         static int shiftleft(SignedInt_t *Value_prm,const int Carry_prm) { return shiftleft(Value_prm->Value,Carry_prm);}
         static int shiftright(SignedInt_t *Value_prm,const int Carry_prm) { return shiftright(Value_prm->Value,Carry_prm);}
+        // mixed width helpers, B is BLimbs limbs of magnitude with its own sign
+        static void AddShort(SignedInt_t *A,const int64 *B,const int BLimbs,const int BNegative);
+        static void MultiplyShort(SignedInt_t *A,const int64 *B,const int BLimbs,const int BNegative);
+        static int CompareShort(const SignedInt_t &A,const int64 *B,const int BLimbs,const int BNegative);
+        static int Compare64(const SignedInt_t &A,const int64 B) { int64 b=Magnitude(B); return CompareShort(A,&b,1,B<0);}
+        static int64 Magnitude(const int64 Value) { return (Value<0)?(int64)(0-(uint64)Value):Value;}
+        template<class NarrowT> static BaseIntT Widen(const NarrowT &Value) { BaseIntT ret(0); for (int x=0;x<NarrowT::limbs;x++) BaseIntT::LimbPtr(&ret)[x]=NarrowT::LimbPtr(Value)[x]; return ret;}
         
 //  private:
         BaseIntT Value;
@@ -273,9 +509,24 @@ template<class BaseIntT> int DoubleInt_t<BaseIntT>::AddDouble(DoubleInt_t *A,con
 
 template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::MultiplyDouble(DoubleInt_t *A,const DoubleInt_t &B)
 {
+    if (A==&B)
+    {
+        return SquareDouble(A);
+    }
+    if (limbs*64>=DOUBLEINT_FLAT_MULTIPLY_BITS)
+    {
+        return MultiplyFlat(A,B);
+    }
+    if (depth>=DOUBLEINT_KARATSUBA_DEPTH)
+    {
+        return MultiplyKaratsuba(A,B);
+    }
+    if ((limbs*64>=DOUBLEINT_COMBA_MIN_BITS) && (limbs*64<=DOUBLEINT_COMBA_BITS))
+    {
+        return MultiplyComba(A,B);
+    }
+
     DoubleInt_t ret;
-    BaseIntT  tmp=0;
-    BaseIntT  col3=0;
 
     // a 128 bit multiply works like when you were in grade school except that instead of the max value per column being
     // a 9 the max value is 2^64. 
@@ -289,30 +540,22 @@ template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::MultiplyDo
     //+ac 
     //-------
     // wxyz
-    BaseIntT a=A->Hi;
-    BaseIntT b=A->Lo;
-    BaseIntT c=B.Hi;
-    BaseIntT d=B.Lo;
-    BaseIntT w=0;
-    BaseIntT x=0;
-    BaseIntT y=0;
-    BaseIntT z=0;
-    int   carry=0;
-    int   carry2=0;
-    BaseIntT xp=0;
-    
-    y=BaseIntT::MultiplyDouble(&b,d);
-    z=b; b=A->Lo;
-    x=BaseIntT::MultiplyDouble(&a,d);
-    carry=BaseIntT::AddDouble(&y,a,0);//    y+=a; 
-    a=A->Hi;
-    xp=BaseIntT::MultiplyDouble(&b,c); 
-    carry=BaseIntT::AddDouble(&x,xp,carry); //x+=xp+carry;
-    carry2=BaseIntT::AddDouble(&y,b,0);   //y+=b; 
-    w=BaseIntT::MultiplyDouble(&a,c); 
-    carry2=BaseIntT::AddDouble(&x,a,carry2);//x+=a; 
+    // the multiplies leave the low half in their first operand, so each
+    // one gets its own copy of a or b and c,d are used where they sit
+    BaseIntT z=A->Lo;
+    BaseIntT y=BaseIntT::MultiplyDouble(&z,B.Lo);     //bd
+    BaseIntT ad=A->Hi;
+    BaseIntT x=BaseIntT::MultiplyDouble(&ad,B.Lo);
+    int carry=BaseIntT::AddDouble(&y,ad,0);          //y+=ad.lo
+    BaseIntT bc=A->Lo;
+    BaseIntT xp=BaseIntT::MultiplyDouble(&bc,B.Hi);
+    carry=BaseIntT::AddDouble(&x,xp,carry);         //x+=bc.hi+carry
+    int carry2=BaseIntT::AddDouble(&y,bc,0);         //y+=bc.lo
+    BaseIntT ac=A->Hi;
+    BaseIntT w=BaseIntT::MultiplyDouble(&ac,B.Hi);
+    carry2=BaseIntT::AddDouble(&x,ac,carry2);       //x+=ac.lo
     // final w fixup
-    BaseIntT longcarry=carry2;
+    BaseIntT longcarry=carry; //carry out of x+=xp
     BaseIntT::AddDouble(&w,longcarry,carry2);
 
 
@@ -325,6 +568,259 @@ template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::MultiplyDo
 }
 
 
+// Same contract as MultiplyDouble (low half in A, high half returned) but only
+// three half width multiplies. 
+//   ab
+//*  cd
+//------
+//   bd
+//  (a+b)(c+d)-ac-bd    (aka ad+bc)
+//+ac
+//-------
+// wxyz
+// a+b and c+d are one bit wider than BaseIntT so their carries are folded
+// back into the middle product by hand.
+template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::MultiplyKaratsuba(DoubleInt_t *A,const DoubleInt_t &B)
+{
+    DoubleInt_t ret;
+    BaseIntT s1=A->Hi;
+    int      s1carry=BaseIntT::AddDouble(&s1,A->Lo,0);
+    BaseIntT s2=B.Hi;
+    int      s2carry=BaseIntT::AddDouble(&s2,B.Lo,0);
+
+    BaseIntT z=A->Lo;
+    BaseIntT y=BaseIntT::MultiplyDouble(&z,B.Lo);  //bd
+    BaseIntT x=A->Hi;
+    BaseIntT w=BaseIntT::MultiplyDouble(&x,B.Hi);  //ac
+
+    // (a+b)(c+d) -> mtop:mhi:mlo
+    BaseIntT mlo=s1;
+    BaseIntT mhi=BaseIntT::MultiplyDouble(&mlo,s2);
+    int      mtop=s1carry&s2carry;
+    if (s1carry)
+    {
+        mtop+=BaseIntT::AddDouble(&mhi,s2,0);
+    }
+    if (s2carry)
+    {
+        mtop+=BaseIntT::AddDouble(&mhi,s1,0);
+    }
+
+    // remove ac and bd, this can't go negative
+    int borrow=BaseIntT::SubDouble(&mlo,z,0);
+    borrow=BaseIntT::SubDouble(&mhi,y,borrow);
+    mtop-=borrow;
+    borrow=BaseIntT::SubDouble(&mlo,x,0);
+    borrow=BaseIntT::SubDouble(&mhi,w,borrow);
+    mtop-=borrow;
+
+    // add the middle term in at the half word offset, mtop is 0 or 1 here
+    int carry=BaseIntT::AddDouble(&y,mlo,0);
+    carry=BaseIntT::AddDouble(&x,mhi,carry);
+    BaseIntT longcarry=int64(mtop);
+    BaseIntT::AddDouble(&w,longcarry,carry);
+
+    A->Lo=z;
+    A->Hi=y;
+    ret.Lo=x;
+    ret.Hi=w;
+
+    return ret;
+}
+
+
+// Same contract as MultiplyDouble with B==A. The cross products ad and bc are
+// equal, so there is one half width multiply and two (recursive) squares
+//   ab
+//*  ab
+//------
+//   bb
+// 2ab
+//+aa
+//-------
+// wxyz
+template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::SquareDouble(DoubleInt_t *A)
+{
+    if (limbs*64>=DOUBLEINT_FLAT_MULTIPLY_BITS)
+    {
+        return MultiplyFlat(A,*A);
+    }
+    if (depth>=DOUBLEINT_KARATSUBA_DEPTH)
+    {
+        return SquareKaratsuba(A);
+    }
+
+    DoubleInt_t ret;
+    BaseIntT z=A->Lo;
+    BaseIntT y=BaseIntT::SquareDouble(&z);   //bb
+    BaseIntT x=A->Hi;
+    BaseIntT w=BaseIntT::SquareDouble(&x);   //aa
+    BaseIntT mlo=A->Lo;
+    BaseIntT mhi=BaseIntT::MultiplyDouble(&mlo,A->Hi); //ab
+
+    // 2ab
+    int mtop=BaseIntT::AddDouble(&mlo,mlo,0);
+    mtop=BaseIntT::AddDouble(&mhi,mhi,mtop);
+
+    int carry=BaseIntT::AddDouble(&y,mlo,0);
+    carry=BaseIntT::AddDouble(&x,mhi,carry);
+    BaseIntT longcarry=int64(mtop);
+    BaseIntT::AddDouble(&w,longcarry,carry);
+
+    A->Lo=z;
+    A->Hi=y;
+    ret.Lo=x;
+    ret.Hi=w;
+
+    return ret;
+}
+
+
+// Karatsuba for squares, 2ab=(a+b)^2-aa-bb so all three half width 
+// products are squares too.
+template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::SquareKaratsuba(DoubleInt_t *A)
+{
+    DoubleInt_t ret;
+    BaseIntT s=A->Hi;
+    int      scarry=BaseIntT::AddDouble(&s,A->Lo,0);
+
+    BaseIntT z=A->Lo;
+    BaseIntT y=BaseIntT::SquareDouble(&z);  //bb
+    BaseIntT x=A->Hi;
+    BaseIntT w=BaseIntT::SquareDouble(&x);  //aa
+
+    // (a+b)^2 -> mtop:mhi:mlo, the carry bit c adds 2cs+c
+    BaseIntT mlo=s;
+    BaseIntT mhi=BaseIntT::SquareDouble(&mlo);
+    int      mtop=scarry;
+    if (scarry)
+    {
+        mtop+=BaseIntT::AddDouble(&mhi,s,0);
+        mtop+=BaseIntT::AddDouble(&mhi,s,0);
+    }
+
+    // remove aa and bb, this can't go negative
+    int borrow=BaseIntT::SubDouble(&mlo,z,0);
+    borrow=BaseIntT::SubDouble(&mhi,y,borrow);
+    mtop-=borrow;
+    borrow=BaseIntT::SubDouble(&mlo,x,0);
+    borrow=BaseIntT::SubDouble(&mhi,w,borrow);
+    mtop-=borrow;
+
+    int carry=BaseIntT::AddDouble(&y,mlo,0);
+    carry=BaseIntT::AddDouble(&x,mhi,carry);
+    BaseIntT longcarry=int64(mtop);
+    BaseIntT::AddDouble(&w,longcarry,carry);
+
+    A->Lo=z;
+    A->Hi=y;
+    ret.Lo=x;
+    ret.Hi=w;
+
+    return ret;
+}
+
+
+// A=A*B keeping only the low half, what the truncating operators want.
+//   ab
+//*  cd
+//------
+//   bd     (full)
+//  ad      (low half only)
+//  bc      (low half only)
+// ac never reaches the low half. The flattened types don't gain anything from
+// this, their multiply produces the whole product in one go anyway.
+template<class BaseIntT> void DoubleInt_t<BaseIntT>::MultiplyLow(DoubleInt_t *A,const DoubleInt_t &B)
+{
+    if (limbs*64>=DOUBLEINT_FLAT_MULTIPLY_BITS)
+    {
+        MultiplyFlat(A,B);
+        return;
+    }
+
+    BaseIntT cross=A->Hi;
+    BaseIntT lo=A->Lo;
+    BaseIntT hi;
+    if (A==&B)
+    {
+        // square, ab==ba so just double it
+        BaseIntT::MultiplyLow(&cross,A->Lo);
+        BaseIntT::AddDouble(&cross,cross,0);
+        hi=BaseIntT::SquareDouble(&lo);
+    }
+    else
+    {
+        BaseIntT cross2=B.Hi;
+        BaseIntT::MultiplyLow(&cross,B.Lo);
+        BaseIntT::MultiplyLow(&cross2,A->Lo);
+        BaseIntT::AddDouble(&cross,cross2,0);
+        hi=BaseIntT::MultiplyDouble(&lo,B.Lo);
+    }
+    BaseIntT::AddDouble(&hi,cross,0);
+    A->Lo=lo;
+    A->Hi=hi;
+}
+
+
+// Same contract as MultiplyDouble, the operands are multiplied in place with
+// Toom-3 or the NTT (see FastMultiply.hpp). Only the product needs its own
+// buffer since it's split between A and the return value.
+template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::MultiplyFlat(DoubleInt_t *A,const DoubleInt_t &B)
+{
+    DoubleInt_t ret;
+    LimbBuffer_t<limbs*2> product;
+    if (A==&B)
+    {
+        SquareLimbs(product,LimbPtr(*A),limbs);
+    }
+    else
+    {
+        MultiplyLimbs(product,LimbPtr(*A),LimbPtr(B),limbs);
+    }
+    SetLimbs(A,product);
+    SetLimbs(&ret,&product[limbs]);
+    return ret;
+}
+
+
+// Same contract as MultiplyDouble, each limb of the product is formed by
+// one column sum and written once rather than going through the four half
+// products and the carry passes between them. The Size passed to the
+// kernel is clamped so that the types that never get here don't unroll it.
+template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::MultiplyComba(DoubleInt_t *A,const DoubleInt_t &B)
+{
+    DoubleInt_t ret;
+    LimbBuffer_t<limbs*2> product;
+    MultiplyLimbsComba<(limbs*64<=DOUBLEINT_COMBA_BITS)?limbs:1>(product,LimbPtr(*A),LimbPtr(B));
+    SetLimbs(A,product);
+    SetLimbs(&ret,&product[limbs]);
+    return ret;
+}
+
+
+// (ret:A)=A+B*C
+template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::AddMulDouble(DoubleInt_t *A,const DoubleInt_t &B,const DoubleInt_t &C)
+{
+    DoubleInt_t ret;
+    LimbBuffer_t<limbs*2> r;
+    AddMulLimbs(r,LimbPtr(*A),LimbPtr(B),LimbPtr(C),limbs);
+    SetLimbs(A,r);
+    SetLimbs(&ret,&r[limbs]);
+    return ret;
+}
+
+// A-=B*C, returns what that borrowed from above (A-B*C=A'-ret*2^size)
+template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::SubMulDouble(DoubleInt_t *A,const DoubleInt_t &B,const DoubleInt_t &C)
+{
+    DoubleInt_t ret;
+    LimbBuffer_t<limbs*2> r;
+    SubMulLimbs(r,LimbPtr(*A),LimbPtr(B),LimbPtr(C),limbs);
+    SetLimbs(A,r);
+    SetLimbs(&ret,&r[limbs]);
+    return ret;
+}
+
+
 template<class BaseIntT> int DoubleInt_t<BaseIntT>::shiftright(DoubleInt_t *Value,const int Carry_prm)
 {
     int carry_ret;
@@ -343,28 +839,37 @@ template<class BaseIntT> int DoubleInt_t<BaseIntT>::shiftleft(DoubleInt_t *Value
 }
 
 
-template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::DivideDouble(DoubleInt_t *A,const DoubleInt_t &B)
+// multi bit shifts, these move whole limbs at a time rather than looping over
+// shiftleft/shiftright. Returns the last bit shifted out.
+template<class BaseIntT> int DoubleInt_t<BaseIntT>::shiftleftn(DoubleInt_t *Value,const int Count)
+{
+    return ShiftLeftLimbs(LimbPtr(Value),limbs,Count);
+}
+
+
+template<class BaseIntT> int DoubleInt_t<BaseIntT>::shiftrightn(DoubleInt_t *Value,const int Count)
 {
-    DoubleInt_t quotient=*A;
-    DoubleInt_t remainder;//==0
+    return ShiftRightLimbs(LimbPtr(Value),limbs,Count);
+}
 
-    if ((DoubleInt_t)(B)==0) //TODO: fix this const mess
+
+template<class BaseIntT> DoubleInt_t<BaseIntT> DoubleInt_t<BaseIntT>::DivideDouble(DoubleInt_t *A,const DoubleInt_t &B)
+{
+    DoubleInt_t remainder;
+    LimbBuffer_t<limbs> a;
+
+    // the quotient and remainder are written straight into A and the return
+    // value, so only the dividend (which the quotient overwrites) is copied
+    GetLimbs(*A,a);
+    const int64 *b=(A==&B)?(const int64 *)a:LimbPtr(B);
+    if (limbs>=DOUBLEINT_NEWTON_DIVIDE_LIMBS)
     {
-        throw "division by zero";
+        DivideLimbsNewton(LimbPtr(A),LimbPtr(&remainder),a,b,limbs);
     }
-    
-    for (int x=0;x<A->size;x++)
+    else
     {
-        int hibit=shiftleft(&quotient,0);
-        shiftleft(&remainder,hibit);
-        if (remainder>=B)
-        {
-            SubDouble(&remainder,B,0); //remainder-=*B;
-            quotient.Lo|=1; //quotient|=1;
-        }
+        DivideLimbs(LimbPtr(A),LimbPtr(&remainder),a,b,limbs);
     }
-
-    *A=quotient;
     return remainder;
 }
 
@@ -379,25 +884,32 @@ template<class BaseIntT> string DoubleInt_t<BaseIntT>::AsString(const char *form
     {
         case 'd':
         {
-            char temp[2];
-            DoubleInt_t tmp;
-            int x=0;
-            tmp=*this;
-            if (tmp==0)
+            // peel off 19 digits at a time with the single limb divide, the
+            // length shrinks as the top limbs go to zero
+            char temp[24];
+            std::vector<int64> limb(limbs);
+            std::vector<int64> chunks;
+            GetLimbs(*this,&limb[0]);
+            int used=limbs;
+            while ((used>0) && (limb[used-1]==0))
             {
-                ret="0";
+                used--;
             }
-            else
+            do
             {
-                ret="";
-                temp[1]='\0';
-                
-                while (tmp!=0)
+                chunks.push_back(DivideLimbsByLimb(&limb[0],used,DECIMAL_CHUNK));
+                while ((used>0) && (limb[used-1]==0))
                 {
-                    DoubleInt_t remainder=DivideDouble(&tmp,DoubleInt_t(10)); //TODO: convert to something a little faster...
-                    temp[0]=remainder.GetLowByte()+'0';
-                    ret.insert(0,string(temp));
+                    used--;
                 }
+            } while (used>0);
+
+            sprintf(temp,"%llu",(uint64)chunks.back());
+            ret=temp;
+            for (int x=chunks.size()-2;x>=0;x--)
+            {
+                sprintf(temp,"%019llu",(uint64)chunks[x]);
+                ret+=temp;
             }
         }
         break;
@@ -435,10 +947,7 @@ template<class BaseIntT> string DoubleInt_t<BaseIntT>::AsString(const char *form
                 {
                     temp[x]+='0';
                 }
-                shiftright(&tmp,0);
-                shiftright(&tmp,0);
-                shiftright(&tmp,0);
-                shiftright(&tmp,0);
+                shiftrightn(&tmp,4);
             }
             ret=temp;
             delete temp;
@@ -449,65 +958,160 @@ template<class BaseIntT> string DoubleInt_t<BaseIntT>::AsString(const char *form
 }
 
 // takes the value as a base 10 or base 16 string and converts it to the big integer type
+// see ParseLimbs, the value is read straight into the limbs
 template<class BaseIntT> void DoubleInt_t<BaseIntT>::FromString(const char *Source_prm)
 {
-    int start=0;
-    int base=10;
-    Hi=Lo=0;
-    while (Source_prm[start]!='\0')
+    ParseLimbs(LimbPtr(this),limbs,Source_prm);
+}
+
+
+//
+//
+//          int256 and int512
+//
+//
+// The two sizes that get used the most skip the Hi/Lo composition and go
+// straight to the unrolled kernels in SmallKernels.hpp. The products are
+// formed in a local buffer since the kernels read A and B while they write R.
+
+template<> inline int DoubleInt_t<int128>::AddDouble(DoubleInt_t *A,const DoubleInt_t &B,const int carry) { return AddLimbs4(LimbPtr(A),LimbPtr(B),carry);}
+template<> inline int DoubleInt_t<int128>::SubDouble(DoubleInt_t *A,const DoubleInt_t &B,const int borrow) { return SubLimbs4(LimbPtr(A),LimbPtr(B),borrow);}
+template<> inline bool DoubleInt_t<int128>::operator==(const DoubleInt_t &rhs) { return EqualLimbsN<4>(LimbPtr(*this),LimbPtr(rhs));}
+template<> inline bool DoubleInt_t<int128>::operator!=(const DoubleInt_t &rhs) { return !EqualLimbsN<4>(LimbPtr(*this),LimbPtr(rhs));}
+
+template<> inline DoubleInt_t<int128> DoubleInt_t<int128>::SquareDouble(DoubleInt_t *A)
+{
+    DoubleInt_t ret;
+    int64 product[8];
+    SquareLimbs4(product,LimbPtr(*A));
+    SetLimbs(A,product);
+    SetLimbs(&ret,&product[4]);
+    return ret;
+}
+
+template<> inline DoubleInt_t<int128> DoubleInt_t<int128>::MultiplyDouble(DoubleInt_t *A,const DoubleInt_t &B)
+{
+    if (A==&B)
     {
-        if (Source_prm[start]=='0')
-        {
-            if (Source_prm[start+1]=='x')
-            {
-                base=16;
-                start+=2;
-            }
-            break;
-        }
-        if ((Source_prm[start]>='0') && (Source_prm[start]<='9'))
-        {
-            break;
-        }
-        start++;
+        return SquareDouble(A);
     }
-    // ok we found the beginning of the string..
-    if (base==10)
+    DoubleInt_t ret;
+    int64 product[8];
+    MultiplyLimbs4(product,LimbPtr(*A),LimbPtr(B));
+    SetLimbs(A,product);
+    SetLimbs(&ret,&product[4]);
+    return ret;
+}
+
+template<> inline void DoubleInt_t<int128>::MultiplyLow(DoubleInt_t *A,const DoubleInt_t &B)
+{
+    int64 product[4];
+    MultiplyLowLimbs4(product,LimbPtr(*A),LimbPtr(B));
+    SetLimbs(A,product);
+}
+
+template<> inline int DoubleInt_t<DoubleInt_t<int128> >::AddDouble(DoubleInt_t *A,const DoubleInt_t &B,const int carry) { return AddLimbs8(LimbPtr(A),LimbPtr(B),carry);}
+template<> inline int DoubleInt_t<DoubleInt_t<int128> >::SubDouble(DoubleInt_t *A,const DoubleInt_t &B,const int borrow) { return SubLimbs8(LimbPtr(A),LimbPtr(B),borrow);}
+template<> inline bool DoubleInt_t<DoubleInt_t<int128> >::operator==(const DoubleInt_t &rhs) { return EqualLimbsN<8>(LimbPtr(*this),LimbPtr(rhs));}
+template<> inline bool DoubleInt_t<DoubleInt_t<int128> >::operator!=(const DoubleInt_t &rhs) { return !EqualLimbsN<8>(LimbPtr(*this),LimbPtr(rhs));}
+
+template<> inline DoubleInt_t<DoubleInt_t<int128> > DoubleInt_t<DoubleInt_t<int128> >::SquareDouble(DoubleInt_t *A)
+{
+    DoubleInt_t ret;
+    int64 product[16];
+    SquareLimbs8(product,LimbPtr(*A));
+    SetLimbs(A,product);
+    SetLimbs(&ret,&product[8]);
+    return ret;
+}
+
+template<> inline DoubleInt_t<DoubleInt_t<int128> > DoubleInt_t<DoubleInt_t<int128> >::MultiplyDouble(DoubleInt_t *A,const DoubleInt_t &B)
+{
+    if (A==&B)
     {
-        DoubleInt_t multconst(10);
-        while ((Source_prm[start]<='9') && (Source_prm[start]>='0'))
-        {
-            char tmp=Source_prm[start]-'0';
-            MultiplyDouble(this,multconst);
-            AddDouble(this,DoubleInt_t(tmp),0);
-            start++;
-        }
+        return SquareDouble(A);
+    }
+    DoubleInt_t ret;
+    int64 product[16];
+    MultiplyLimbs8(product,LimbPtr(*A),LimbPtr(B));
+    SetLimbs(A,product);
+    SetLimbs(&ret,&product[8]);
+    return ret;
+}
+
+template<> inline void DoubleInt_t<DoubleInt_t<int128> >::MultiplyLow(DoubleInt_t *A,const DoubleInt_t &B)
+{
+    int64 product[8];
+    MultiplyLowLimbs8(product,LimbPtr(*A),LimbPtr(B));
+    SetLimbs(A,product);
+}
+
+// The whole product of two IntT as the next size up, two int256 make an
+// int512. The result's Lo:Hi is its flat limb array so the product is written
+// there directly, rather than MultiplyDouble's halves being copied into it.
+//
+//   int4096 p=WideMultiply(a,b);   // a,b int2048
+//   int2048 r=red.Reduce(p);
+template<class IntT> inline DoubleInt_t<IntT> WideSquare(const IntT &A)
+{
+    DoubleInt_t<IntT> ret;
+    if (IntT::limbs*64>=2*DOUBLEINT_WIDE_FLAT_BITS)
+    {
+        SquareLimbs(DoubleInt_t<IntT>::LimbPtr(&ret),IntT::LimbPtr(A),IntT::limbs);
     }
     else
     {
-        char upper=toupper(Source_prm[start]);
-        while (((upper<='9') && (upper>='0')) || ((upper>='A') && (upper<='F')))
-        {
-            char tmp;
-            if (upper<='9')
-            {
-                tmp=upper-'0';
-            }
-            else
-            {
-                tmp=upper-'A';
-            }
-            shiftleft(this,0);
-            shiftleft(this,0);
-            shiftleft(this,0);
-            shiftleft(this,0);
-            Lo|=int64(tmp);
-            start++;
-            upper=toupper(Source_prm[start]);
-        }
+        ret.Lo=A;
+        ret.Hi=IntT::SquareDouble(&ret.Lo);
     }
+    return ret;
 }
 
+template<class IntT> inline DoubleInt_t<IntT> WideMultiply(const IntT &A,const IntT &B)
+{
+    if (&A==&B)
+    {
+        return WideSquare(A);
+    }
+    DoubleInt_t<IntT> ret;
+    if (IntT::limbs*64>=DOUBLEINT_WIDE_FLAT_BITS)
+    {
+        MultiplyLimbs(DoubleInt_t<IntT>::LimbPtr(&ret),IntT::LimbPtr(A),IntT::LimbPtr(B),IntT::limbs);
+    }
+    else
+    {
+        ret.Lo=A;
+        ret.Hi=IntT::MultiplyDouble(&ret.Lo,B);
+    }
+    return ret;
+}
+
+// Compile time constants. The same parser as FromString, but the result can be
+// folded into the binary rather than parsed at startup:
+//
+//   constexpr int2048 p=ConstFromString<int2048>("0xFFFFFFFF...");
+//   constexpr int1024 q=1234567890123456789012345678901234567890_u1024;
+//   constexpr int256  g=0x79BE667EF9DCBBAC'55A06295CE870B07_u256;
+template<class IntT> constexpr IntT ConstFromString(const char *Source)
+{
+    int64 limbs[IntT::limbs]={};
+    ParseLimbs(limbs,IntT::limbs,Source);
+    return IntT::FromLimbs(limbs);
+}
+
+template<class IntT,char... Digits> constexpr IntT ConstFromDigits()
+{
+    const char digits[]={Digits...,'\0'};
+    return ConstFromString<IntT>(digits);
+}
+
+template<char... Digits> constexpr int128 operator"" _u128() { return ConstFromDigits<int128,Digits...>();}
+template<char... Digits> constexpr DoubleInt_t<int128> operator"" _u256() { return ConstFromDigits<DoubleInt_t<int128>,Digits...>();}
+template<char... Digits> constexpr DoubleInt_t<DoubleInt_t<int128> > operator"" _u512() { return ConstFromDigits<DoubleInt_t<DoubleInt_t<int128> >,Digits...>();}
+template<char... Digits> constexpr DoubleInt_t<DoubleInt_t<DoubleInt_t<int128> > > operator"" _u1024() { return ConstFromDigits<DoubleInt_t<DoubleInt_t<DoubleInt_t<int128> > >,Digits...>();}
+template<char... Digits> constexpr DoubleInt_t<DoubleInt_t<DoubleInt_t<DoubleInt_t<int128> > > > operator"" _u2048() { return ConstFromDigits<DoubleInt_t<DoubleInt_t<DoubleInt_t<DoubleInt_t<int128> > > >,Digits...>();}
+template<char... Digits> constexpr DoubleInt_t<DoubleInt_t<DoubleInt_t<DoubleInt_t<DoubleInt_t<int128> > > > > operator"" _u4096() { return ConstFromDigits<DoubleInt_t<DoubleInt_t<DoubleInt_t<DoubleInt_t<DoubleInt_t<int128> > > > >,Digits...>();}
+
 
 template<class BaseIntT> int SignedInt_t<BaseIntT>::AddDouble(SignedInt_t *A,const SignedInt_t &B,const int carry)
 {
@@ -560,25 +1164,88 @@ template<class BaseIntT> int SignedInt_t<BaseIntT>::AddDouble(SignedInt_t *A,con
     }
 }
 
-// flip the sign of A and add them...
+// A-B is -(-A+B), flip the sign of A add them and flip it back (0 stays positive)
 template<class BaseIntT> int SignedInt_t<BaseIntT>::SubDouble(SignedInt_t *A,const SignedInt_t &B,const int borrow)
 {
     A->Negative^=1; //negate the sign with xor <chuckle>
-    return AddDouble(A,B,0);
+    int ret=AddDouble(A,B,0);
+    if (A->Value!=0)
+    {
+        A->Negative^=1;
+    }
+    return ret;
 }
 
-//TODO make a finalizer class which sits between this class and the double template and throws overflow exceptions...
-template<class BaseIntT> SignedInt_t<BaseIntT> SignedInt_t<BaseIntT>::MultiplyDouble(SignedInt_t *A,const SignedInt_t &B)
+// A+=B with B only BLimbs wide, same fun as AddDouble but without the copies
+template<class BaseIntT> void SignedInt_t<BaseIntT>::AddShort(SignedInt_t *A,const int64 *B,const int BLimbs,const int BNegative)
 {
-    BaseIntT::MultiplyDouble(&A->Value,B.Value);
-    if (A->Value==0)
+    int64 *value=BaseIntT::LimbPtr(&A->Value);
+    if (A->Negative==BNegative)
     {
-        A->Negative=0;
+        AddLimbsShort(value,BaseIntT::limbs,B,BLimbs);
+        return;
     }
-    else
+    if (CompareLimbsShort(value,BaseIntT::limbs,B,BLimbs)>=0)
     {
-        A->Negative^=B.Negative; //flip sign as nessiary
+        SubLimbsShort(value,BaseIntT::limbs,B,BLimbs);
+        if (A->Value==0)
+        {
+            A->Negative=0;
+        }
+        return;
     }
+    // |A|<|B| so A fits in BLimbs, B-A is -(A-B) and takes B's sign
+    SubLimbs(value,B,BLimbs,0);
+    int carry=1;
+    for (int x=0;x<BLimbs;x++)
+    {
+        value[x]=~value[x]+carry;
+        carry=carry && (value[x]==0);
+    }
+    A->Negative=BNegative;
+}
+
+template<class BaseIntT> void SignedInt_t<BaseIntT>::MultiplyShort(SignedInt_t *A,const int64 *B,const int BLimbs,const int BNegative)
+{
+    MultiplyLimbsShort(BaseIntT::LimbPtr(&A->Value),BaseIntT::limbs,B,BLimbs);
+    A->Negative=(A->Value==0)?0:A->Negative^BNegative;
+}
+
+template<class BaseIntT> int SignedInt_t<BaseIntT>::CompareShort(const SignedInt_t &A,const int64 *B,const int BLimbs,const int BNegative)
+{
+    if (A.Negative!=BNegative)
+    {
+        return A.Negative?-1:1;
+    }
+    int ret=CompareLimbsShort(BaseIntT::LimbPtr(A.Value),BaseIntT::limbs,B,BLimbs);
+    return A.Negative?-ret:ret;
+}
+
+//TODO make a finalizer class which sits between this class and the double template and throws overflow exceptions...
+template<class BaseIntT> SignedInt_t<BaseIntT> SignedInt_t<BaseIntT>::MultiplyDouble(SignedInt_t *A,const SignedInt_t &B)
+{
+    SignedInt_t ret;
+    ret.Value=BaseIntT::MultiplyDouble(&A->Value,B.Value);
+    int Negative=A->Negative^B.Negative; //flip sign as nessiary
+    A->Negative=(A->Value==0)?0:Negative;
+    ret.Negative=(ret.Value==0)?0:Negative;
+    return ret;
+}
+
+template<class BaseIntT> void SignedInt_t<BaseIntT>::MultiplyLow(SignedInt_t *A,const SignedInt_t &B)
+{
+    int Negative=A->Negative^B.Negative;
+    BaseIntT::MultiplyLow(&A->Value,B.Value);
+    A->Negative=(A->Value==0)?0:Negative;
+}
+
+// squares are never negative
+template<class BaseIntT> SignedInt_t<BaseIntT> SignedInt_t<BaseIntT>::SquareDouble(SignedInt_t *A)
+{
+    SignedInt_t ret;
+    ret.Value=BaseIntT::SquareDouble(&A->Value);
+    A->Negative=0;
+    return ret;
 }
 
 template<class BaseIntT> SignedInt_t<BaseIntT> SignedInt_t<BaseIntT>::DivideDouble(SignedInt_t *A,const SignedInt_t &B)
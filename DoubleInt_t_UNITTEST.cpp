@@ -46,6 +46,9 @@
 
 
 #include "DoubleInt_t.hpp"
+#include "Montgomery.hpp"
+#include "BatchInt.hpp"
+#include "MontgomeryBatch.hpp"
 
 
 #define _UNITTEST_ //for now just leave the unittest on
@@ -68,11 +71,34 @@ typedef class DoubleInt_t<int64kB>   int128kB;
 typedef class DoubleInt_t<int128kB>  int256kB;
 typedef class DoubleInt_t<int256kB>  int512kB;
 typedef class DoubleInt_t<int512kB>  int1MB;
+typedef class HeapInt_t<int1MB>      hint1MB;
 // Much beyond 1MB and this won't compile in any reasonable amount of 
 // time. Plus the operations are _REALLY_ slow. 
 
 typedef class SignedInt_t<int256>    sint256; //signed 256 bit int
 
+typedef class FixedInt_t<8>                fint512;  //flat limb versions
+typedef class DoubleInt_t<FixedInt_t<4> >  fdint512;
+typedef class SignedInt_t<FixedInt_t<4> >  sfint256;
+
+typedef class DoubleInt_t<bint128>    bint256;  //compiler builtin base
+typedef class DoubleInt_t<bint256>    bint512;
+typedef class DoubleInt_t<bint512>    bint1024;
+typedef class DoubleInt_t<bint1024>   bint2048;
+typedef class DoubleInt_t<bint2048>   bint4096;
+
+// the same int128_t under another name, DoubleInt_t of it isn't specialized
+// so gint256/gint512 are the generic Hi/Lo composition of int256/int512
+class gint128_t : public int128_t
+{
+    public:
+        gint128_t() {}
+        gint128_t(const int128_t &orig):int128_t(orig) {}
+        constexpr gint128_t(const int64 &orig):int128_t(orig) {}
+};
+typedef class DoubleInt_t<gint128_t>  gint256;
+typedef class DoubleInt_t<gint256>    gint512;
+
 
 // for 64-bit x86
 unsigned long long rdtsc(void)
@@ -141,6 +167,33 @@ void Test64BitBase(void)
         printf("remainder=%llX, a=%llX b=%llX c=%llX\n",overflow,a,b,c);
         overflow=Divide64(&a,&b,&c);
     }
+
+    // row multiply/add against Multiply64/Add64, odd lengths run the
+    // single limb loop of the mulx version as well as the unrolled one
+    bool same=true;
+    for (int size=1;size<12;size++)
+    {
+        int64 r[12],check[13],src[12];
+        int64 mul=0x9e3779b97f4a7c15LL*size;
+        for (int x=0;x<size;x++)
+        {
+            src[x]=0xd1b54a32d192ed03LL*(x+1)-size;
+            r[x]=-1-x;
+            check[x]=r[x];
+        }
+        check[size]=AddMulLimb(r,src,size,mul);
+        int64 carry=0;
+        for (int x=0;x<size;x++)
+        {
+            int64 lo=src[x];
+            int64 hi=Multiply64(&lo,&mul);
+            hi+=Add64(&lo,&carry,0);
+            carry=hi+Add64(&check[x],&lo,0);
+            same=same && (check[x]==r[x]);
+        }
+        same=same && (check[size]==carry);
+    }
+    printf("AddMulLimb %s (mulx/adx %s)\n",same?"ok":"MISMATCH",DoubleIntHaveAdx?"available":"not available");
 }
 
 void Test128BitTemplate(void)
@@ -422,6 +475,78 @@ void Test512BitTemplate(void)
     }
     rdtscll(end);
     printf("int512 operator *= %llu cycles a loop\n",(end-start)/6);
+
+    // square test, should match the general multiply
+    t128=int512(0xFFFFFFFFFFFFFFFF);
+    int512::MultiplyDouble(&t128,int512(0x123456789ABCDEF));
+    t128<<=200;
+    t128-=int512(1);
+    t2=t128;
+    int512 sq=t128;
+    int512 copy=t128;
+    over=int512::MultiplyDouble(&t2,copy);
+    int512 sqover=int512::SquareDouble(&sq);
+    printf("square value=%s over=%s %s\n",sq.AsString("%X").c_str(),sqover.AsString("%X").c_str(),((sq==t2) && (sqover==over))?"matches multiply":"MISMATCH");
+
+    rdtscll(start);
+    for (int x=0;x<6;x++)
+    {
+        sq=t128;
+        over=int512::MultiplyDouble(&sq,copy);
+    }
+    rdtscll(end);
+    printf("int512 MultiplyDouble %llu cycles a loop\n",(end-start)/6);
+    rdtscll(start);
+    for (int x=0;x<6;x++)
+    {
+        sq=t128;
+        over=int512::SquareDouble(&sq);
+    }
+    rdtscll(end);
+    printf("int512 SquareDouble %llu cycles a loop\n",(end-start)/6);
+
+    // truncated multiply, should be the low half of MultiplyDouble
+    sq=t128;
+    over=int512::MultiplyDouble(&sq,copy);
+    int512 low=t128;
+    int512::MultiplyLow(&low,copy);
+    printf("low multiply value=%s %s\n",low.AsString("%X").c_str(),((low==sq) && ((t128*copy)==sq))?"matches multiply":"MISMATCH");
+    rdtscll(start);
+    for (int x=0;x<6;x++)
+    {
+        low=t128;
+        int512::MultiplyLow(&low,copy);
+    }
+    rdtscll(end);
+    printf("int512 MultiplyLow %llu cycles a loop\n",(end-start)/6);
+
+    // multi limb divide, q*b+r should give back the dividend
+    t2=t128;
+    t2>>=190;
+    t2+=int512(0x1234567);
+    int512 quotient=t128;
+    remainder=int512::DivideDouble(&quotient,t2);
+    int512 check=quotient;
+    int512::MultiplyDouble(&check,t2);
+    check+=remainder;
+    printf("divide value=%s by=%s quotient=%s remainder=%s %s\n",t128.AsString("%X").c_str(),t2.AsString("%X").c_str(),quotient.AsString("%X").c_str(),remainder.AsString("%X").c_str(),((check==t128) && (remainder<t2))?"ok":"MISMATCH");
+    rdtscll(start);
+    for (int x=0;x<6;x++)
+    {
+        quotient=t128;
+        remainder=int512::DivideDouble(&quotient,t2);
+    }
+    rdtscll(end);
+    printf("int512 DivideDouble %llu cycles a loop\n",(end-start)/6);
+
+    // single limb divide, should agree with the full width divide
+    quotient=t128;
+    int64 limbremainder=int512::DivideByLimb(&quotient,1000003);
+    t2=t128;
+    remainder=int512::DivideDouble(&t2,int512(1000003));
+    printf("limb divide value=%s quotient=%s remainder=%lld mod=%lld %s\n",t128.AsString("%d").c_str(),quotient.AsString("%d").c_str(),limbremainder,int512::ModByLimb(t128,1000003),((quotient==t2) && (remainder==int512(limbremainder)))?"ok":"MISMATCH");
+    int128 small=t128.Lo.Lo;
+    printf("int128 decimal %s\n",small.AsString("%d").c_str());
 }
 
 
@@ -451,6 +576,19 @@ void Test16384BitTemplate(void)
     }
     rdtscll(end);
     printf("16k operator *= %llu cycles a loop\n",(end-start)/6);
+    rdtscll(start);
+    for (int x=0;x<6;x++)
+    {
+        over=int16384::SquareDouble(&t128);
+    }
+    rdtscll(end);
+    printf("16k SquareDouble Took %llu cycles a loop\n",(end-start)/6);
+    t128=int16384(0);
+    t128-=int16384(1); //all ones
+    rdtscll(start);
+    string decimal=t128.AsString("%d");
+    rdtscll(end);
+    printf("16k AsString(%%d) %d digits Took %llu cycles\n",(int)decimal.length(),(end-start));
 
     rdtscll(start);
     for (int x=0;x<6;x++)
@@ -458,7 +596,23 @@ void Test16384BitTemplate(void)
         t128/=t2;
     }
     rdtscll(end);
-    printf("16k operator /= %llu cycles a loop\n",(end-start)/6);   
+    printf("16k operator /= %llu cycles a loop\n",(end-start)/6);
+
+    // starting from nothing the kernel scratch should settle into one block,
+    // sized by what these needed at once, and another round shouldn't grow
+    // it. Dividing by itself works in place too.
+    ScratchArena_t::Release();
+    over=int16384::MultiplyDouble(&t128,t2);
+    over=int16384::SquareDouble(&t128);
+    t128/=t2;
+    int64 scratch=ScratchArena_t::Reserved();
+    over=int16384::MultiplyDouble(&t128,t2);
+    over=int16384::SquareDouble(&t128);
+    t128/=t2;
+    bool settled=(ScratchArena_t::State().Blocks.size()==1) && (ScratchArena_t::Reserved()==scratch);
+    settled=settled && (scratch<=std::max<int64>(DOUBLEINT_SCRATCH_LIMBS,24*int16384::limbs));
+    t2/=t2;
+    printf("16k scratch %s at %lld limbs, x/=x %s\n",settled?"settled":"GROWING",scratch,(t2==int16384(1))?"ok":"WRONG");
 }
 
 void Test131072BitTemplate(void)
@@ -494,27 +648,38 @@ void Test131072BitTemplate(void)
     }
     rdtscll(end);
     printf("128k operator /= %llu cycles a loop\n",(end-start)/6);
+
+    // wide divisor, this takes the Newton reciprocal path
+    t128=int131072(0);
+    t128-=int131072(1);
+    t2=t128;
+    t2>>=60000;
+    int131072 quotient=t128;
+    rdtscll(start);
+    int131072 remainder=int131072::DivideDouble(&quotient,t2);
+    rdtscll(end);
+    int131072 check=quotient;
+    check*=t2;
+    check+=remainder;
+    printf("128k wide DivideDouble %s Took %llu cycles\n",((check==t128) && (remainder<t2))?"ok":"MISMATCH",(end-start));
 }
 
 
 void Test1MBTemplate(void)
 {
-    int512kB  test=1024*1024*1024;
-    int1MB t128,t2, over;
+    // at a megabyte a value these live in the heap pools, see HeapInt_t.hpp
+    hint1MB t128,t2, over;
 
-    printf("This is going to take a while, if it crashes verify your stack space...\n");
+    printf("This is going to take a while...\n");
 
-    test=0xF;
-    t128=test;
-    test=0x10;
-    t2=test;
-    test=0;
-    over=test;
+    t128=hint1MB(0xF);
+    t2=hint1MB(0x10);
+    over=hint1MB(0);
     int64 start,end;
     rdtscll(start);
     for (int x=0;x<2;x++)
     {
-        over=int1MB::MultiplyDouble(&t128,t2);
+        over=hint1MB::MultiplyDouble(&t128,t2);
     }
     rdtscll(end);
     printf("1M MultiplyDouble Took %llu cycles a loop\n",(end-start)/2);
@@ -532,6 +697,34 @@ void Test1MBTemplate(void)
     }
     rdtscll(end);
     printf("1M operator /= %llu cycles a loop\n",(end-start)/2);
+
+    // wide divisor, this takes the Newton reciprocal path
+    t128=hint1MB(0);
+    t128-=hint1MB(1);
+    t2=t128;
+    t2>>=4000000;
+    hint1MB quotient=t128;
+    rdtscll(start);
+    hint1MB remainder=hint1MB::DivideDouble(&quotient,t2);
+    rdtscll(end);
+    hint1MB check=quotient*t2+remainder;
+    printf("1M wide DivideDouble %s Took %llu cycles\n",((check==t128) && (remainder<t2))?"ok":"MISMATCH",(end-start));
+
+    // what the scratch keeps afterwards is one block of the most that was in
+    // use at once, a small multiple of the operand size
+    const int64 limbs=hint1MB::limbs;
+    int64 kept=ScratchArena_t::Reserved();
+    ScratchArena_t::Release();
+    over=hint1MB::MultiplyDouble(&t128,t2);
+    int64 mul=ScratchArena_t::Reserved();
+    ScratchArena_t::Release();
+    quotient=check;
+    remainder=hint1MB::DivideDouble(&quotient,t2);
+    int64 div=ScratchArena_t::Reserved();
+    bool bounded=(ScratchArena_t::State().Blocks.size()==1) && (mul<=24*limbs) && (div<=32*limbs) && (kept<=32*limbs);
+    ScratchArena_t::Release();
+    printf("1M scratch %s, kept %.1fn, multiply %.1fn, divide %.1fn limbs, released %lld\n",bounded?"bounded":"UNBOUNDED",
+           kept/(double)limbs,mul/(double)limbs,div/(double)limbs,ScratchArena_t::Reserved());
 }
 
 void TestSignedValue(void)
@@ -596,34 +789,975 @@ void TestSignedValue(void)
     }
 }
 
+// MultiplyDouble/SquareDouble against the flat grade school multiply, all ones
+// runs a carry through every column (the Add64 carry in, the final w fixup)
+template<class IntT> bool CheckKaratsuba(IntT a,IntT b)
+{
+    IntT lo=a;
+    IntT hi=IntT::MultiplyDouble(&lo,b);
+    IntT sqlo=a;
+    IntT sqhi=IntT::SquareDouble(&sqlo);
+    int64 product[IntT::limbs*2],square[IntT::limbs*2];
+    MultiplyLimbsBasecase(product,IntT::LimbPtr(a),IntT::limbs,IntT::LimbPtr(b),IntT::limbs);
+    SquareLimbsBasecase(square,IntT::LimbPtr(a),IntT::limbs);
+    bool same=true;
+    for (int x=0;x<IntT::limbs;x++)
+    {
+        same=same && (IntT::LimbPtr(lo)[x]==product[x]) && (IntT::LimbPtr(hi)[x]==product[IntT::limbs+x]);
+        same=same && (IntT::LimbPtr(sqlo)[x]==square[x]) && (IntT::LimbPtr(sqhi)[x]==square[IntT::limbs+x]);
+    }
+    return same;
+}
+
+template<class IntT> bool CompareKaratsuba(void)
+{
+    IntT ones=IntT(0)-IntT(1);
+    IntT r1,r2;
+    uint64 seed=IntT::limbs;
+    for (int x=0;x<IntT::limbs;x++)
+    {
+        seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+        IntT::LimbPtr(&r1)[x]=(int64)seed;
+        seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+        IntT::LimbPtr(&r2)[x]=(int64)seed;
+    }
+    // ones in the low half only, so the middle term carries into zeros
+    IntT half=ones>>(IntT::size/2);
+    return CheckKaratsuba(ones,ones) && CheckKaratsuba(ones,IntT(1)) && CheckKaratsuba(ones,r1) && CheckKaratsuba(r1,r2) &&
+           CheckKaratsuba(half,ones) && CheckKaratsuba(half,half);
+}
+
+void TestKaratsuba(void)
+{
+    // gint512 is still the grade school composition, and so is int128 without ADX
+    bool same=CompareKaratsuba<int2048>() && CompareKaratsuba<int4096>();
+    same=CompareKaratsuba<gint512>() && CompareKaratsuba<int128>() && same;
+    printf("Karatsuba/grade school multiply carries %s\n",same?"ok":"MISMATCH");
+}
+
+// MultiplyLimbs/SquareLimbs against the grade school loops either side of
+// where they switch to Toom-3 and the NTT
+bool CheckLimbMultiply(const int Size,const bool Ones)
+{
+    std::vector<int64> a(Size),b(Size),r(2*Size),ref(2*Size);
+    uint64 seed=Size;
+    for (int x=0;x<Size;x++)
+    {
+        seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+        a[x]=Ones?-1:(int64)seed;
+        seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+        b[x]=Ones?-1:(int64)seed;
+    }
+    MultiplyLimbs(r.data(),a.data(),b.data(),Size);
+    MultiplyLimbsBasecase(ref.data(),a.data(),Size,b.data(),Size);
+    bool same=(r==ref);
+    SquareLimbs(r.data(),a.data(),Size);
+    SquareLimbsBasecase(ref.data(),a.data(),Size);
+    return same && (r==ref);
+}
+
+void TestToom3Ntt(void)
+{
+    const int sizes[]={DOUBLEINT_TOOM3_LIMBS,DOUBLEINT_TOOM3_SQUARE_LIMBS,DOUBLEINT_NTT_LIMBS};
+    bool same=true;
+    for (int x=0;x<3;x++)
+    {
+        for (int y=sizes[x]-1;y<=sizes[x]+1;y++)
+        {
+            same=CheckLimbMultiply(y,false) && CheckLimbMultiply(y,true) && same;
+        }
+    }
+    printf("Toom-3/NTT multiply %s\n",same?"ok":"MISMATCH");
+}
+
+void TestMontgomery(void)
+{
+    // modulus 0x5555...5, exponent m-2 so every window size gets used
+    int2048 m=int2048(0);
+    m-=int2048(1);
+    m/=int2048(3);
+    int2048 e=m;
+    e-=int2048(2);
+    int2048 base=int2048(0x123456789abcdefLL);
+    base=base.Square();
+    base=base.Square();
+    base=base.Square();
+    base=base.Square();
+    base=base.Square();
+
+    MontgomeryContext_t<int2048> ctx(m);
+    int64 start,end;
+    rdtscll(start);
+    int2048 result=ctx.ModPow(base,e);
+    rdtscll(end);
+    printf("2048 Montgomery ModPow Took %llu cycles\n",(end-start));
+
+    // plain square and multiply with a double width remainder
+    int4096 wm,w;
+    wm.Hi=int2048(0);
+    wm.Lo=m;
+    int2048 acc=int2048(1);
+    int2048 b=base%m;
+    rdtscll(start);
+    for (int x=2047;x>=0;x--)
+    {
+        w.Hi=int2048(0);
+        w.Lo=acc;
+        w=w.Square()%wm;
+        acc=w.Lo;
+        if ((e>>x).GetLowByte()&1)
+        {
+            w.Hi=int2048(0);
+            w.Lo=acc;
+            int4096 wb;
+            wb.Hi=int2048(0);
+            wb.Lo=b;
+            w=(w*wb)%wm;
+            acc=w.Lo;
+        }
+    }
+    rdtscll(end);
+    printf("2048 Montgomery ModPow %s, DivideDouble ModPow Took %llu cycles\n",(result==acc)?"ok":"MISMATCH",(end-start));
+
+    int2048 x=ctx.ToMontgomery(b);
+    int2048 sq=ctx.FromMontgomery(ctx.Square(x));
+    int2048 mul=ctx.FromMontgomery(ctx.Multiply(x,x));
+    w.Hi=int2048(0);
+    w.Lo=b;
+    w=w.Square()%wm;
+    printf("2048 Montgomery Square/Multiply %s\n",((sq==w.Lo) && (mul==w.Lo))?"ok":"MISMATCH");
+
+    // same product through the Barrett reducer, then a batch against %
+    BarrettReducer_t<int2048> red(m);
+    int2048 lo=b;
+    int2048 hi=int2048::MultiplyDouble(&lo,b);
+    printf("2048 Barrett Reduce %s\n",((red.Reduce(hi,lo)==w.Lo) && (red.Reduce(WideMultiply(b,b))==w.Lo))?"ok":"MISMATCH");
+    int2048 batch[64],check[64];
+    for (int x=0;x<64;x++)
+    {
+        batch[x]=base;
+        batch[x]<<=x;
+        check[x]=batch[x];
+    }
+    rdtscll(start);
+    red.ReduceN(batch,64);
+    rdtscll(end);
+    printf("2048 Barrett ReduceN Took %llu cycles a value\n",(end-start)/64);
+    bool same=true;
+    rdtscll(start);
+    for (int x=0;x<64;x++)
+    {
+        check[x]=check[x]%m;
+    }
+    rdtscll(end);
+    for (int x=0;x<64;x++)
+    {
+        same=same && (check[x]==batch[x]);
+    }
+    printf("2048 Barrett ReduceN %s, operator %% Took %llu cycles a value\n",same?"ok":"MISMATCH",(end-start)/64);
+}
+
+
+// the flat limb class by itself and as the doubler's base should give the
+// same answers as the nested int512
+template<class FixedT> bool CompareFixed(const int512 &A,const FixedT &B)
+{
+    int64 a[int512::limbs],b[FixedT::limbs];
+    int512::GetLimbs(A,a);
+    FixedT::GetLimbs(B,b);
+    for (int x=0;x<int512::limbs;x++)
+    {
+        if (a[x]!=b[x])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<class FixedT> void TestFixedAgainst512(const char *name)
+{
+    int64 limb[int512::limbs];
+    int512 a=int512(0x123456789abcdefLL),b,c,d;
+    a=a.Square().Square().Square();
+    a-=int512(1);
+    b=a;
+    b>>=77;
+    FixedT fa,fb,fc,fd;
+    int512::GetLimbs(a,limb);
+    FixedT::SetLimbs(&fa,limb);
+    int512::GetLimbs(b,limb);
+    FixedT::SetLimbs(&fb,limb);
+
+    bool same=CompareFixed(a+b,fa+fb) && CompareFixed(b-a,fb-fa) && CompareFixed(a*b,fa*fb);
+    same=same && CompareFixed(a/b,fa/fb) && CompareFixed(a%b,fa%fb) && CompareFixed(a<<129,fa<<129) && CompareFixed(a>>3,fa>>3);
+    c=a;
+    d=int512::MultiplyDouble(&c,b);
+    fc=fa;
+    fd=FixedT::MultiplyDouble(&fc,fb);
+    same=same && CompareFixed(c,fc) && CompareFixed(d,fd);
+    c=a;
+    d=int512::SquareDouble(&c);
+    fc=fa;
+    fd=FixedT::SquareDouble(&fc);
+    same=same && CompareFixed(c,fc) && CompareFixed(d,fd);
+    same=same && (a.AsString("%d")==fa.AsString("%d")) && (a.AsString("%X")==fa.AsString("%X"));
+    same=same && (int512::ModByLimb(a,1000000007)==FixedT::ModByLimb(fa,1000000007)) && ((a>b)==(fa>fb)) && ((b>=a)==(fb>=fa));
+    fc.FromString(a.AsString("%d").c_str());
+    same=same && CompareFixed(a,fc);
+
+    int64 start,end;
+    rdtscll(start);
+    for (int x=0;x<1000;x++)
+    {
+        fc=fa;
+        fd=FixedT::MultiplyDouble(&fc,fb);
+    }
+    rdtscll(end);
+    printf("%s against int512 %s, MultiplyDouble Took %llu cycles\n",name,same?"ok":"MISMATCH",(end-start)/1000);
+}
+
+void TestFixedInt(void)
+{
+    TestFixedAgainst512<fint512>("FixedInt_t<8>");
+    TestFixedAgainst512<fdint512>("DoubleInt_t<FixedInt_t<4> >");
+    int512 a=int512(0x123456789abcdefLL),b=int512(0xfedcba987654321LL);
+    int64 start,end;
+    rdtscll(start);
+    for (int x=0;x<1000;x++)
+    {
+        b=a;
+        int512::MultiplyDouble(&b,a);
+    }
+    rdtscll(end);
+    printf("int512 MultiplyDouble Took %llu cycles\n",(end-start)/1000);
+
+    // signed, same values as TestSignedValue
+    int64 testvals[]={11,10,9,1,0,-1,-9,-10,-11};
+    bool same=true;
+    for (int x=0;x<9;x++)
+    {
+        for (int y=0;y<9;y++)
+        {
+            sint256 sx=sint256(testvals[x]),sy=sint256(testvals[y]);
+            sfint256 fx=sfint256(testvals[x]),fy=sfint256(testvals[y]);
+            same=same && ((sx+sy).AsString("%d")==(fx+fy).AsString("%d")) && ((sx-sy).AsString("%d")==(fx-fy).AsString("%d"));
+            same=same && ((sx*sy).AsString("%d")==(fx*fy).AsString("%d")) && ((sx>=sy)==(fx>=fy)) && ((sx<sy)==(fx<fy));
+            if (testvals[y]!=0)
+            {
+                same=same && ((sx/sy).AsString("%d")==(fx/fy).AsString("%d"));
+            }
+        }
+    }
+    printf("SignedInt_t<FixedInt_t<4> > against sint256 %s\n",same?"ok":"MISMATCH");
+}
+
+// operator chains reuse their temporaries in place, check them against the
+// same thing done one step at a time
+void TestOperatorChains(void)
+{
+    int2048 a=int2048(0x123456789abcdefLL),b=int2048(0x7edcba987654321LL);
+    a=a.Square();
+    a=a.Square();
+    a=a.Square();
+    b=b.Square();
+    b=b.Square();
+    int2048 c=a;
+    c-=b;
+    int2048 d=b;
+    d<<=700;
+    int2048 e=a;
+    e>>=9;
+
+    int2048 chain=a*b+c*d-e;
+    int2048 step=a;
+    step*=b;
+    int2048 tmp=c;
+    tmp*=d;
+    step+=tmp;
+    step-=e;
+    bool same=(chain==step);
+
+    chain=e+a*b;
+    step=a;
+    step*=b;
+    step+=e;
+    same=same && (chain==step);
+
+    chain=a*(b+c);
+    step=b;
+    step+=c;
+    step*=a;
+    same=same && (chain==step);
+
+    chain=(a*b)%e;
+    step=a;
+    step*=b;
+    step%=e;
+    same=same && (chain==step);
+
+    chain=((a*b)<<5)>>3;
+    step=a;
+    step*=b;
+    step<<=5;
+    step>>=3;
+    same=same && (chain==step);
+
+    // a chain bound to a reference keeps its value alive
+    const int2048 &bound=a*b+c;
+    auto &&fbound=fint512(7)*fint512(6)+fint512(1);
+    same=same && ((a*b+c)==bound) && (fbound==fint512(43));
+
+    sint256 x=sint256(-11),y=sint256(10),z=sint256(3);
+    same=same && ((x*y+z).AsString("%d")=="-107") && ((z+x*y).AsString("%d")=="-107") && ((x*(y+z)).AsString("%d")=="-143");
+
+    HeapInt_t<int2048> ha=a,hb=b,hc=c,hd=d,he=e;
+    HeapInt_t<int2048> hchain=ha*hb+hc*hd-he;
+    same=same && (*hchain.Value==a*b+c*d-e);
+    printf("operator chains %s\n",same?"ok":"MISMATCH");
+
+    int64 start,end;
+    rdtscll(start);
+    for (int x=0;x<1000;x++)
+    {
+        chain=a+b+c+d-e;
+    }
+    rdtscll(end);
+    printf("int2048 a+b+c+d-e Took %llu cycles\n",(end-start)/1000);
+}
+
+// acc+=b*c, checked against the separate multiply and add. Subtracting then
+// adding the same product back has to give the original value and the same
+// high half.
+template<class IntT> bool CheckAddMul(IntT a,IntT b,IntT c,int64 l)
+{
+    IntT sum=a;
+    IntT hi=IntT::AddMulDouble(&sum,b,c);
+    IntT lo=b;
+    IntT check=IntT::MultiplyDouble(&lo,c);
+    int carry=IntT::AddDouble(&lo,a,0);
+    IntT::AddDouble(&check,IntT(int64(carry)),0);
+    bool same=(sum==lo) && (hi==check);
+
+    IntT diff=a;
+    IntT borrow=IntT::SubMulDouble(&diff,b,c);
+    same=same && (IntT::AddMulDouble(&diff,b,c)==borrow) && (diff==a);
+
+    diff=a;
+    int64 limb=IntT::SubMulLimb(&diff,b,l);
+    same=same && (IntT::AddMulLimb(&diff,b,l)==limb) && (diff==a);
+    return same;
+}
+
+void TestAddMul(void)
+{
+    int2048 a=int2048(0x123456789abcdefLL),b=int2048(0x7edcba987654321LL),c=int2048(0);
+    c-=int2048(3);
+    for (int x=0;x<5;x++)
+    {
+        a=a.Square()+int2048(0x51);
+        b=b.Square()+int2048(0x77);
+    }
+    bool same=CheckAddMul<int2048>(a,b,c,-5) && CheckAddMul<int2048>(c,c,c,0x1234567) && CheckAddMul<int2048>(a,c,b,-1);
+    same=same && CheckAddMul<int128>(int128(-7),int128(-9),int128(0x1234567),-3);
+    same=same && CheckAddMul<int256>(int256(-7),int256(-9),int256(0x1234567),-3);
+    same=same && CheckAddMul<fint512>(fint512(-7),fint512(-9),fint512(-1),-3);
+    same=same && CheckAddMul<int16384>(int16384(0)-int16384(1),int16384(0)-int16384(5),int16384(0)-int16384(9),-3);
+
+    int64 start,end;
+    int2048 acc=a;
+    rdtscll(start);
+    for (int x=0;x<1000;x++)
+    {
+        c=int2048::AddMulDouble(&acc,a,b);
+    }
+    rdtscll(end);
+    printf("AddMulDouble/SubMulDouble %s, int2048 AddMulDouble Took %llu cycles\n",same?"ok":"MISMATCH",(end-start)/1000);
+}
+
 
 // run the basic tests..
-#include <sys/resource.h>
-int main(int argc,char *argv[])
+// int64 and narrower operands against the same thing widened to the full type
+void TestMixedWidth(void)
 {
-    // for the 1MB objects the stack size needs to be adjusted..
-    rlimit newlimit;
-    if (getrlimit(RLIMIT_STACK,&newlimit)!=0)
+    int4096 x=int4096(0x3141592653589793LL);
+    int256 n=int256(0x2718281828459045LL);
+    for (int y=0;y<6;y++)
     {
-        perror("Unable to get stack limit");
+        x=x.Square()+int4096(0x1f);
     }
-    else
+    n=n.Square()+int256(0x33);
+    int4096 wide=int4096(int2048(int1024(int512(n))));
+    int64 l=-12345;
+    int4096 lwide=int4096(l);
+
+    bool same=((x+n)==(x+wide)) && ((x-n)==(x-wide)) && ((x*n)==(x*wide)) && ((x/n)==(x/wide)) && ((x%n)==(x%wide));
+    same=same && ((x+l)==(x+lwide)) && ((x-l)==(x-lwide)) && ((x*l)==(x*lwide)) && ((x/l)==(x/lwide)) && ((x%l)==(x%lwide));
+    same=same && ((l+x)==(x+lwide)) && ((n*x)==(x*wide)) && (x>n) && (x!=l) && !(wide<n) && (wide==n) && (int4096(7)==7);
+    int4096 top=int4096(0)-int4096(1);
+    same=same && ((top+1)==0) && ((int4096(0)-1)==top);
+
+    sint256 a=sint256(-7),b=sint256(10);
+    same=same && ((a-b)==-17) && ((b-a)==17) && ((a-a)==0) && ((a+3)==-4) && ((a-(-7))==0) && ((a*-3)==21);
+    same=same && ((sint256(-17)/5)==-3) && ((sint256(-17)%5)==-2) && ((sint256(17)%sint256(-5))==2) && (a<n) && (a<-6) && (a>-8);
+    same=same && ((a+n-n)==a) && ((a*n/n)==a);
+    // temporaries bound to references outlive the statement
+    const int4096 &pl=(x*x)+l;
+    const int4096 &pn=(x*x)-n;
+    auto &&sa=(a*b)+3;
+    same=same && ((x*x+lwide)==pl) && ((x*x-wide)==pn) && (sa==-67);
+
+    int64 start,end;
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
     {
-        printf("current stack size %d, max limit %d\n",newlimit.rlim_cur,newlimit.rlim_max);
+        x+=1;
     }
-    //newlimit.rlim_max=1024L*1024L*64L; //64M stack...
-    newlimit.rlim_cur=1024L*1024L*64L; //64M stack...
-    if (setrlimit(RLIMIT_STACK, &newlimit)!=0)
+    rdtscll(end);
+    int64 narrow=(end-start)/1000;
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
+    {
+        x+=int4096(1);
+    }
+    rdtscll(end);
+    printf("mixed width ops %s, int4096+=1 Took %llu cycles (%llu widened)\n",same?"ok":"MISMATCH",narrow,(end-start)/1000);
+}
+
+// the wide product against MultiplyDouble's two halves
+template<class IntT> bool CheckWide(IntT a,IntT b)
+{
+    IntT lo=a;
+    IntT hi=IntT::MultiplyDouble(&lo,b);
+    IntT sqlo=a;
+    IntT sqhi=IntT::SquareDouble(&sqlo);
+    DoubleInt_t<IntT> p=WideMultiply(a,b);
+    DoubleInt_t<IntT> sq=WideSquare(a);
+    DoubleInt_t<IntT> self=WideMultiply(a,a);
+    return (p.Lo==lo) && (p.Hi==hi) && (sq.Lo==sqlo) && (sq.Hi==sqhi) && (self.Lo==sqlo) && (self.Hi==sqhi);
+}
+
+void TestWideMultiply(void)
+{
+    int2048 a=int2048(0x123456789abcdefLL),b=int2048(0)-int2048(0x77);
+    for (int x=0;x<5;x++)
     {
-        perror("Unable to set stack limit, check ulimit -s unlimited, or comment out the exit(1) and the Test1MBTemplate");
-        return 1;
+        a=a.Square()+int2048(0x51);
     }
+    bool same=CheckWide<int2048>(a,b) && CheckWide<int128>(int128(-7),int128(-9));
+    same=same && CheckWide<int256>(int256(0)-int256(7),int256(0)-int256(9)) && CheckWide<int512>(int512(0)-int512(3),int512(0x1234567));
+    same=same && CheckWide<int1024>(int1024(0)-int1024(3),int1024(0)-int1024(1)) && CheckWide<FixedInt_t<8> >(FixedInt_t<8>(-1),FixedInt_t<8>(-5));
 
+    int64 start,end;
+    int4096 p;
+    rdtscll(start);
+    for (int x=0;x<1000;x++)
+    {
+        p=WideMultiply(a,b);
+    }
+    rdtscll(end);
+    printf("WideMultiply/WideSquare %s, int2048 WideMultiply Took %llu cycles\n",same?"ok":"MISMATCH",(end-start)/1000);
+}
+
+// the literals are folded at compile time, the static_asserts prove it
+void TestConstants(void)
+{
+    constexpr int256 g=0x79BE667EF9DCBBAC'55A06295CE870B07'029BFCDB2DCE28D9'59F2815B16F81798_u256;
+    static_assert((g.Lo.Lo==0x59F2815B16F81798LL) && ((uint64)g.Hi.Hi==0x79BE667EF9DCBBACULL),"hex literal");
+    constexpr int128 t=18446744073709551617_u128;
+    static_assert((t.Lo==1) && (t.Hi==1),"decimal literal");
+    constexpr int1024 q=1234567890123456789012345678901234567890_u1024;
+    constexpr fint512 f=ConstFromString<fint512>("0xdeadBEEF00000000000000001");
+    static_assert((f.Limb[0]==1) && (f.Limb[1]==0xdeadbeef0LL),"ConstFromString");
+
+    int256 rg;
+    rg.FromString("0x79BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798");
+    int1024 rq;
+    rq.FromString("1234567890123456789012345678901234567890");
+    bool same=(rg==g) && (rq==q) && (rq.AsString("%d")=="1234567890123456789012345678901234567890");
+
+    int64 start,end;
+    int2048 x;
+    rdtscll(start);
+    for (int y=0;y<100;y++)
+    {
+        x.FromString("32317006071311007300714876688669951960444102669715484032130345427524655138867890893197201411522913463688717960921898019494119559150490921095088152386448283120630877367300996091750197750389652106796057638384067568276792218642619756161838094338476170470581645852036305042887575891541065808607552399123930385521914333389668342420684974786564569494856176035326322058077805659331026192708460314150258592864177116725943603718461857357598351152301645904403697613233287231227125684710820209725157101726931323469678542580656697935045997268352998638215525166389437335543602135433229604645318478604952148193555853611059596230655");
+    }
+    rdtscll(end);
+    same=same && (x==(int2048(0)-int2048(1)));
+    printf("constants/FromString %s, 2048 bit decimal FromString Took %llu cycles\n",same?"ok":"MISMATCH",(end-start)/100);
+}
+
+// same limbs, other backend
+template<class ToT,class FromT> ToT SameLimbs(const FromT &x)
+{
+    ToT ret;
+    for (int y=0;y<ToT::limbs;y++)
+    {
+        ToT::LimbPtr(&ret)[y]=FromT::LimbPtr(x)[y];
+    }
+    return ret;
+}
+
+// every op on both backends has to give the same limbs
+template<class AsmT,class BuiltinT> bool CheckBackend(AsmT a,AsmT b)
+{
+    BuiltinT ba=SameLimbs<BuiltinT>(a),bb=SameLimbs<BuiltinT>(b);
+    AsmT half=b>>(AsmT::size/2);
+    BuiltinT bhalf=bb>>(BuiltinT::size/2);
+    bool same=(SameLimbs<AsmT>(ba+bb)==(a+b)) && (SameLimbs<AsmT>(ba-bb)==(a-b)) && (SameLimbs<AsmT>(ba*bb)==(a*b));
+    same=same && (SameLimbs<AsmT>(ba.Square())==a.Square()) && (SameLimbs<AsmT>(ba/bhalf)==(a/half)) && (SameLimbs<AsmT>(ba%bhalf)==(a%half));
+    same=same && (SameLimbs<AsmT>(ba<<77)==(a<<77)) && (SameLimbs<AsmT>(ba>>77)==(a>>77)) && ((ba<bb)==(a<b));
+
+    BuiltinT blo=ba;
+    BuiltinT bhi=BuiltinT::MultiplyDouble(&blo,bb);
+    AsmT lo=a;
+    AsmT hi=AsmT::MultiplyDouble(&lo,b);
+    same=same && (SameLimbs<AsmT>(blo)==lo) && (SameLimbs<AsmT>(bhi)==hi) && (ba.AsString("%d")==a.AsString("%d"));
+    return same;
+}
+
+// add/mul/square/divide cycles for one width of one backend
+template<class IntT> void TimeBackend(IntT a,IntT b,int64 *cycles)
+{
+    int64 start,end;
+    IntT x=a,half=(b>>(IntT::size/2))+IntT(1);
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
+    {
+        x+=b;
+    }
+    rdtscll(end);
+    cycles[0]=(end-start)/1000;
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
+    {
+        x=x*b;
+    }
+    rdtscll(end);
+    cycles[1]=(end-start)/1000;
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
+    {
+        x=x.Square()+b;
+    }
+    rdtscll(end);
+    cycles[2]=(end-start)/1000;
+    rdtscll(start);
+    for (int y=0;y<100;y++)
+    {
+        x=(x+b)/half+a;
+    }
+    rdtscll(end);
+    cycles[3]=(end-start)/100;
+    if (x==a) //keep the loops
+    {
+        printf(" ");
+    }
+}
+
+template<class AsmT,class BuiltinT> bool CompareBackends(AsmT seed)
+{
+    AsmT a=seed,b=AsmT(0)-seed;
+    for (int x=0;x<8;x++)
+    {
+        a=a.Square()+AsmT(0x3b);
+        b=b*a+AsmT(0x1d);
+    }
+    bool same=CheckBackend<AsmT,BuiltinT>(a,b) && CheckBackend<AsmT,BuiltinT>(AsmT(0)-AsmT(1),a);
+    int64 asmc[4],bc[4];
+    TimeBackend<AsmT>(a,b,asmc);
+    TimeBackend<BuiltinT>(SameLimbs<BuiltinT>(a),SameLimbs<BuiltinT>(b),bc);
+    printf("%5d bits add %3llu/%-3llu mul %5llu/%-5llu square %5llu/%-5llu divide %6llu/%-6llu cycles (asm/builtin) %s\n",
+           AsmT::size,asmc[0],bc[0],asmc[1],bc[1],asmc[2],bc[2],asmc[3],bc[3],same?"ok":"MISMATCH");
+    return same;
+}
+
+// the inline asm int128_t base against the compiler builtin one
+void TestBuiltinBackend(void)
+{
+    int128 seed=int128(0x0123456789abcdefLL);
+    bool same=(SameLimbs<int128>(SameLimbs<bint128>(seed)*bint128(-3))==seed*int128(-3));
+    same=CompareBackends<int128,bint128>(seed) && same;
+    same=CompareBackends<int256,bint256>(int256(seed)) && same;
+    same=CompareBackends<int512,bint512>(int512(int256(seed))) && same;
+    same=CompareBackends<int1024,bint1024>(int1024(int512(int256(seed)))) && same;
+    same=CompareBackends<int2048,bint2048>(int2048(int1024(int512(int256(seed))))) && same;
+    same=CompareBackends<int4096,bint4096>(int4096(int2048(int1024(int512(int256(seed)))))) && same;
+    printf("builtin backend %s\n",same?"ok":"MISMATCH");
+}
+
+// add/sub/mul/square/compare cycles for the specialized and the generic type
+template<class IntT> void TimeKernels(IntT a,IntT b,int64 *cycles)
+{
+    int64 start,end;
+    IntT x=a,hi;
+    int less=0;
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
+    {
+        x+=b;
+        x-=a;
+    }
+    rdtscll(end);
+    cycles[0]=(end-start)/1000;
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
+    {
+        hi=IntT::MultiplyDouble(&x,b);
+    }
+    rdtscll(end);
+    cycles[1]=(end-start)/1000;
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
+    {
+        hi=IntT::SquareDouble(&x);
+        x+=b;
+    }
+    rdtscll(end);
+    cycles[2]=(end-start)/1000;
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
+    {
+        x*=b;
+    }
+    rdtscll(end);
+    cycles[3]=(end-start)/1000;
+    rdtscll(start);
+    for (int y=0;y<1000;y++)
+    {
+        less+=(x<b);
+        x+=hi;
+    }
+    rdtscll(end);
+    cycles[4]=(end-start)/1000;
+    if ((x==a) && (less==7)) //keep the loops
+    {
+        printf(" ");
+    }
+}
+
+template<class IntT,class GenericT> bool CheckKernels(IntT a,IntT b)
+{
+    GenericT ga=SameLimbs<GenericT>(a),gb=SameLimbs<GenericT>(b);
+    bool same=(SameLimbs<IntT>(ga+gb)==(a+b)) && (SameLimbs<IntT>(ga-gb)==(a-b)) && (SameLimbs<IntT>(ga*gb)==(a*b)) && (SameLimbs<IntT>(ga*ga)==(a*a));
+    same=same && ((ga<gb)==(a<b)) && ((ga>gb)==(a>b)) && ((ga<=gb)==(a<=b)) && ((ga>=gb)==(a>=b)) && ((ga==gb)==(a==b)) && ((ga!=gb)==(a!=b));
+    same=same && (a<=a) && (a>=a) && !(a<a) && !(a>a) && (a==a) && !(a!=a);
+    IntT lo=a,sqlo=a;
+    IntT hi=IntT::MultiplyDouble(&lo,b);
+    IntT sqhi=IntT::SquareDouble(&sqlo);
+    GenericT glo=ga,gsqlo=ga;
+    GenericT ghi=GenericT::MultiplyDouble(&glo,gb);
+    GenericT gsqhi=GenericT::SquareDouble(&gsqlo);
+    same=same && (SameLimbs<IntT>(glo)==lo) && (SameLimbs<IntT>(ghi)==hi) && (SameLimbs<IntT>(gsqlo)==sqlo) && (SameLimbs<IntT>(gsqhi)==sqhi);
+    IntT sum=a;
+    GenericT gsum=ga;
+    same=same && (IntT::AddDouble(&sum,b,1)==GenericT::AddDouble(&gsum,gb,1)) && (SameLimbs<IntT>(gsum)==sum);
+    same=same && (IntT::SubDouble(&sum,a,1)==GenericT::SubDouble(&gsum,ga,1)) && (SameLimbs<IntT>(gsum)==sum);
+    same=same && ((a/b)==SameLimbs<IntT>(ga/gb)) && ((b%a)==SameLimbs<IntT>(gb%ga));
+    return same;
+}
+
+template<class IntT,class GenericT> bool CompareKernels(IntT seed)
+{
+    IntT a=seed,b=IntT(0)-seed,top=IntT(0)-IntT(1);
+    bool same=true;
+    for (int x=0;x<8;x++)
+    {
+        same=CheckKernels<IntT,GenericT>(a,b) && CheckKernels<IntT,GenericT>(top,a) && CheckKernels<IntT,GenericT>(b,top) && same;
+        a=a.Square()+IntT(0x3b);
+        b=b*a+IntT(0x1d);
+    }
+    int64 fixed[5],generic[5];
+    TimeKernels<IntT>(a,b,fixed);
+    TimeKernels<GenericT>(SameLimbs<GenericT>(a),SameLimbs<GenericT>(b),generic);
+    printf("%d bits add+sub %llu/%llu MultiplyDouble %llu/%llu SquareDouble %llu/%llu *= %llu/%llu compare %llu/%llu cycles (fixed/generic) %s\n",
+           IntT::size,fixed[0],generic[0],fixed[1],generic[1],fixed[2],generic[2],fixed[3],generic[3],fixed[4],generic[4],same?"ok":"MISMATCH");
+    return same;
+}
+
+// the int256/int512 specializations against the generic composition
+void TestSmallKernels(void)
+{
+    int256 seed=int256(int128(0x0123456789abcdefLL));
+    bool same=CompareKernels<int256,gint256>(seed);
+    same=CompareKernels<int512,gint512>(int512(seed)) && same;
+    printf("int256/int512 kernels %s\n",same?"ok":"MISMATCH");
+}
+
+// MultiplyDouble against the row by row basecase multiply
+template<class IntT> bool CheckComba(IntT a,IntT b)
+{
+    IntT lo=a;
+    IntT hi=IntT::MultiplyDouble(&lo,b);
+    int64 product[IntT::limbs*2];
+    MultiplyLimbsBasecase(product,IntT::LimbPtr(a),IntT::limbs,IntT::LimbPtr(b),IntT::limbs);
+    bool same=true;
+    for (int x=0;x<IntT::limbs;x++)
+    {
+        same=same && (IntT::LimbPtr(lo)[x]==product[x]) && (IntT::LimbPtr(hi)[x]==product[IntT::limbs+x]);
+    }
+    return same;
+}
+
+template<class IntT> bool TimeComba(IntT seed)
+{
+    IntT a=seed,b=IntT(0)-seed,top=IntT(0)-IntT(1);
+    bool same=true;
+    for (int x=0;x<6;x++)
+    {
+        same=CheckComba<IntT>(a,b) && CheckComba<IntT>(top,a) && CheckComba<IntT>(top,top+IntT(0)) && same;
+        a=a.Square()+IntT(0x3b);
+        b=b*a+IntT(0x1d);
+    }
+
+    int64 start,end;
+    IntT lo,hi;
+    int64 product[IntT::limbs*2];
+    rdtscll(start);
+    for (int x=0;x<1000;x++)
+    {
+        lo=a;
+        hi=IntT::MultiplyDouble(&lo,b);
+        a.Lo^=hi.Lo;
+    }
+    rdtscll(end);
+    int64 nested=(end-start)/1000;
+    rdtscll(start);
+    for (int x=0;x<1000;x++)
+    {
+        MultiplyLimbsBasecase(product,IntT::LimbPtr(a),IntT::limbs,IntT::LimbPtr(b),IntT::limbs);
+        a.Lo^=product[IntT::limbs];
+    }
+    rdtscll(end);
+    printf("%d bits MultiplyDouble Took %llu cycles (%llu by rows) %s\n",IntT::size,nested,(end-start)/1000,same?"ok":"MISMATCH");
+    return same;
+}
+
+// int1024 is a Comba multiply, int2048 is Karatsuba over int1024 halves
+void TestComba(void)
+{
+    int1024 seed=int1024(int512(int256(int128(0x0fedcba987654321LL))));
+    bool same=TimeComba<int1024>(seed);
+    same=TimeComba<int2048>(int2048(seed)) && same;
+    same=TimeComba<DoubleInt_t<FixedInt_t<8> > >(DoubleInt_t<FixedInt_t<8> >(FixedInt_t<8>(-77))) && same;
+    printf("Comba multiply %s\n",same?"ok":"MISMATCH");
+}
+
+// limbs of 0, ~0, 1 or noise so the carries run through whole integers
+template<class IntT> void BatchFill(IntT *Values,const size_t N,uint64 *Seed)
+{
+    for (size_t x=0;x<N;x++)
+    {
+        for (int y=0;y<IntT::limbs;y++)
+        {
+            *Seed=*Seed*6364136223846793005ULL+1442695040888963407ULL;
+            int kind=(*Seed>>60)&3;
+            IntT::LimbPtr(&Values[x])[y]=(kind==0)?0:((kind==1)?-1:((kind==2)?1:(int64)(*Seed^(*Seed>>29))));
+        }
+    }
+}
+
+// the batch results against one at a time, also the AVX2 path on its own
+template<class IntT> bool CheckBatch(const size_t N)
+{
+    std::vector<IntT> a(N),b(N),sum(N),diff(N),avx2(N);
+    std::vector<int> cmp(N),eq(N);
+    uint64 seed=N*IntT::limbs;
+    BatchFill<IntT>(a.data(),N,&seed);
+    BatchFill<IntT>(b.data(),N,&seed);
+    for (size_t x=0;x<N;x+=3)
+    {
+        b[x]=a[x];
+        IntT::LimbPtr(&b[x])[(x/3)%IntT::limbs]^=1;
+    }
+    for (size_t x=0;x<N;x+=7)
+    {
+        b[x]=a[x];
+    }
+    AddN(sum.data(),a.data(),b.data(),N);
+    SubN(diff.data(),a.data(),b.data(),N);
+    CompareN(cmp.data(),a.data(),b.data(),N);
+    EqualN(eq.data(),a.data(),b.data(),N);
+    bool same=true;
+    for (size_t x=0;x<N;x++)
+    {
+        same=same && (sum[x]==a[x]+b[x]) && (diff[x]==a[x]-b[x]) && (eq[x]==(a[x]==b[x]));
+        same=same && (cmp[x]==((a[x]<b[x])?-1:((a[x]>b[x])?1:0)));
+    }
+    if (DoubleIntHaveAvx2)
+    {
+        size_t count=BatchCount(IntT::limbs,N,4);
+        AddSubLimbsAvx2(IntT::LimbPtr(&avx2[0]),IntT::LimbPtr(a[0]),IntT::LimbPtr(b[0]),IntT::limbs,count,false);
+        CompareLimbsAvx2(cmp.data(),IntT::LimbPtr(a[0]),IntT::LimbPtr(b[0]),IntT::limbs,count,false);
+        for (size_t x=0;x<count;x++)
+        {
+            same=same && (avx2[x]==sum[x]) && (cmp[x]==((a[x]<b[x])?-1:((a[x]>b[x])?1:0)));
+        }
+        AddSubLimbsAvx2(IntT::LimbPtr(&avx2[0]),IntT::LimbPtr(a[0]),IntT::LimbPtr(b[0]),IntT::limbs,count,true);
+        CompareLimbsAvx2(cmp.data(),IntT::LimbPtr(a[0]),IntT::LimbPtr(b[0]),IntT::limbs,count,true);
+        for (size_t x=0;x<count;x++)
+        {
+            same=same && (avx2[x]==diff[x]) && (cmp[x]==eq[x]);
+        }
+    }
+    // in place, a+b-b is a again
+    std::vector<IntT> orig=a;
+    AddN(a.data(),a.data(),b.data(),N);
+    SubN(a.data(),a.data(),b.data(),N);
+    EqualN(eq.data(),a.data(),orig.data(),N);
+    for (size_t x=0;x<N;x++)
+    {
+        same=same && (a[x]==orig[x]) && eq[x];
+    }
+    return same;
+}
+
+void TestBatch(void)
+{
+    bool same=CheckBatch<int128>(1001) && CheckBatch<int256>(1003) && CheckBatch<int512>(257) && CheckBatch<int1024>(65);
+    same=CheckBatch<int2048>(9) && CheckBatch<FixedInt_t<3> >(100) && CheckBatch<fint512>(31) && CheckBatch<int256>(1) && same;
+
+    const size_t n=4096;
+    std::vector<int256> a(n),b(n),c(n);
+    std::vector<int> cmp(n);
+    uint64 seed=5;
+    BatchFill<int256>(a.data(),n,&seed);
+    BatchFill<int256>(b.data(),n,&seed);
+    int64 start,end;
+    rdtscll(start);
+    for (int y=0;y<10;y++)
+    {
+        for (size_t x=0;x<n;x++)
+        {
+            c[x]=a[x]+b[x];
+        }
+    }
+    rdtscll(end);
+    int64 single=(end-start)/(10*n);
+    rdtscll(start);
+    for (int y=0;y<10;y++)
+    {
+        AddN(c.data(),a.data(),b.data(),n);
+    }
+    rdtscll(end);
+    int64 batch=(end-start)/(10*n);
+    rdtscll(start);
+    for (int y=0;y<10;y++)
+    {
+        CompareN(cmp.data(),a.data(),b.data(),n);
+    }
+    rdtscll(end);
+    printf("batch add/sub/compare %s (%s), int256 a+b Took %llu cycles, AddN %llu, CompareN %llu a value\n",same?"ok":"MISMATCH",
+           DoubleIntHaveAvx512?"AVX-512":(DoubleIntHaveAvx2?"AVX2":"scalar"),single,batch,(end-start)/(10*n));
+}
+
+// a*b mod m and s^65537 mod m against WideMultiply/% and MontgomeryContext_t,
+// on the IFMA kernel (if there is one) and on the lane at a time one
+template<class IntT> bool CheckMontgomeryBatch(const size_t N)
+{
+    std::vector<IntT> a(N),b(N),r(N),p(N);
+    uint64 seed=N+IntT::limbs;
+    BatchFill<IntT>(a.data(),N,&seed);
+    BatchFill<IntT>(b.data(),N,&seed);
+    IntT m;
+    BatchFill<IntT>(&m,1,&seed);
+    IntT::LimbPtr(&m)[0]|=1;
+    IntT::LimbPtr(&m)[IntT::limbs-1]|=0x4000000000000000LL;
+    IntT::LimbPtr(&m)[IntT::limbs-1]&=0x7fffffffffffffffLL;
+    DoubleInt_t<IntT> wm;
+    wm.Hi=IntT(0);
+    wm.Lo=m;
+    for (size_t x=0;x<N;x++)
+    {
+        a[x]=a[x]%m;
+        b[x]=b[x]%m;
+    }
+    a[0]=m-IntT(1);
+    b[0]=m-IntT(1);
+
+    MontgomeryBatch_t<IntT> batch(m);
+    MontgomeryContext_t<IntT> ctx(m);
+    IntT e=IntT(65537);
+    bool same=true;
+    for (int pass=0;pass<2;pass++)
+    {
+        batch.ifma=(pass==0) && DoubleIntHaveIfma;
+        batch.Multiply(r.data(),a.data(),b.data(),N);
+        batch.ModPow(p.data(),a.data(),e,N);
+        for (size_t x=0;x<N;x++)
+        {
+            same=same && (r[x]==(WideMultiply(a[x],b[x])%wm).Lo) && (p[x]==ctx.ModPow(a[x],e));
+        }
+    }
+    return same;
+}
+
+// eight signature checks (s^65537 mod m) at a time against one at a time
+template<class IntT> void TimeMontgomeryBatch(const char *Name)
+{
+    const size_t n=64;
+    std::vector<IntT> s(n),r(n);
+    uint64 seed=3;
+    BatchFill<IntT>(s.data(),n,&seed);
+    IntT m=IntT(0)-IntT(1);
+    for (size_t x=0;x<n;x++)
+    {
+        s[x]=s[x]%m;
+    }
+    MontgomeryContext_t<IntT> ctx(m);
+    MontgomeryBatch_t<IntT> batch(m);
+    IntT e=IntT(65537);
+    int64 start,end;
+    rdtscll(start);
+    for (size_t x=0;x<n;x++)
+    {
+        r[x]=ctx.ModPow(s[x],e);
+    }
+    rdtscll(end);
+    int64 single=(end-start)/n;
+    rdtscll(start);
+    batch.ModPow(r.data(),s.data(),e,n);
+    rdtscll(end);
+    int64 fast=(end-start)/n;
+    batch.ifma=false;
+    rdtscll(start);
+    batch.ModPow(r.data(),s.data(),e,n);
+    rdtscll(end);
+    printf("%s x^65537 mod m Took %llu cycles, batch %llu (%s), lane at a time %llu a value\n",Name,single,fast,
+           DoubleIntHaveIfma?"IFMA":"no IFMA",(end-start)/n);
+}
+
+void TestMontgomeryBatch(void)
+{
+    bool same=CheckMontgomeryBatch<int1024>(8) && CheckMontgomeryBatch<int1024>(13) && CheckMontgomeryBatch<int2048>(11);
+    same=CheckMontgomeryBatch<int512>(3) && CheckMontgomeryBatch<FixedInt_t<17> >(9) && same;
+    printf("Montgomery batch %s\n",same?"ok":"MISMATCH");
+    TimeMontgomeryBatch<int1024>("1024");
+    TimeMontgomeryBatch<int2048>("2048");
+}
+
+int main(int argc,char *argv[])
+{
     Test64BitBase();
     Test128BitTemplate();
     Test256BitTemplate();
     Test512BitTemplate();
     TestSignedValue();
+    TestKaratsuba();
+    TestToom3Ntt();
+    TestMontgomery();
+    TestFixedInt();
+    TestOperatorChains();
+    TestAddMul();
+    TestMixedWidth();
+    TestWideMultiply();
+    TestConstants();
+    TestBuiltinBackend();
+    TestSmallKernels();
+    TestComba();
+    TestBatch();
+    TestMontgomeryBatch();
     Test16384BitTemplate();
     Test131072BitTemplate();
     Test1MBTemplate();
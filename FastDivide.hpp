@@ -0,0 +1,561 @@
+// C++ BigNum template class
+// AKA the integer doubler template.
+// Copyright(C) 2007,2015 Jeremy Linton
+//
+// Source identity: FastDivide.hpp
+//
+// Knuth's Algorithm D (DivideLimbs in int128_t.hpp) is quadratic, which is fine
+// until the divisor is a few hundred limbs long. Past that it is cheaper to
+// compute a fixed point reciprocal of the divisor with Newton's method and then
+// divide by multiplying with it (Barrett's method). Everything here is built on
+// MultiplyLimbs() from FastMultiply.hpp, so the cost of a divide follows the
+// cost of the Toom-3/NTT multiply rather than growing as n^2.
+//
+// See DoubleInt_t.hpp for more information
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+// USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef FASTDIVIDE_HPP
+#define FASTDIVIDE_HPP
+
+#include <vector>
+#include "int128_t.hpp"
+#include "FastMultiply.hpp"
+
+template<class BaseIntT> class DoubleInt_t;
+
+// divisors with this many significant limbs or more are divided with the
+// Newton reciprocal, shorter ones go through Algorithm D. This is also where
+// the reciprocal recursion bottoms out.
+#ifndef DOUBLEINT_NEWTON_DIVIDE_LIMBS
+#define DOUBLEINT_NEWTON_DIVIDE_LIMBS 1024
+#endif
+
+
+// R[0..ASize+BSize)=A*B for operands of different lengths. The longer one is
+// cut into pieces the size of the shorter one so each piece can use MultiplyLimbs.
+static inline void MultiplyLimbsUnbalanced(int64 *R,const int64 *A,const int ASize,const int64 *B,const int BSize)
+{
+    if (ASize<BSize)
+    {
+        MultiplyLimbsUnbalanced(R,B,BSize,A,ASize);
+        return;
+    }
+    if (ASize==BSize)
+    {
+        MultiplyLimbs(R,A,B,ASize);
+        return;
+    }
+    if (BSize<DOUBLEINT_TOOM3_LIMBS)
+    {
+        MultiplyLimbsBasecase(R,A,ASize,B,BSize);
+        return;
+    }
+
+    ScratchFrame_t frame;
+    int64 *piece=ScratchArena_t::Get(ASize+BSize);
+    for (int x=0;x<ASize+BSize;x++)
+    {
+        R[x]=0;
+    }
+    for (int offset=0;offset<ASize;offset+=BSize)
+    {
+        int len=ASize-offset;
+        if (len>BSize)
+        {
+            len=BSize;
+        }
+        MultiplyLimbsUnbalanced(piece,&A[offset],len,B,BSize);
+        AddLimbsAt(R,ASize+BSize,offset,piece,len+BSize);
+    }
+}
+
+// V[0..Size]=floor((2^(128*Size)-1)/B) where B is Size limbs with its top bit
+// set. The result is Size+1 limbs with a top limb of 0 or 1.
+//
+// The top half of B gives a half precision reciprocal Vh (recursively), one
+// Newton step V=Vh+Vh*(1-B*Vh) doubles the precision and a final multiply
+// checks the result and fixes the last few units. The Newton step needs an
+// exact Vh but the Barrett step below copes with a V that is a few units off,
+// so the outermost call can skip that last multiply with Exact=false.
+static inline void ReciprocalLimbs(int64 *V,const int64 *B,const int Size,const bool Exact)
+{
+    const int n=Size;
+    if (n<DOUBLEINT_NEWTON_DIVIDE_LIMBS)
+    {
+        ScratchFrame_t frame;
+        int64 *num=ScratchArena_t::Get(2*n);
+        int64 *div=ScratchArena_t::GetZero(2*n);
+        int64 *q=ScratchArena_t::Get(2*n);
+        int64 *r=ScratchArena_t::Get(2*n);
+        for (int x=0;x<2*n;x++)
+        {
+            num[x]=-1;
+        }
+        for (int x=0;x<n;x++)
+        {
+            div[x]=B[x];
+        }
+        DivideLimbs(q,r,num,div,2*n);
+        for (int x=0;x<=n;x++)
+        {
+            V[x]=q[x];
+        }
+        return;
+    }
+
+    const int h=(n+1)/2;
+    const int l=n-h;
+    ScratchFrame_t frame;
+    int64 *vh=ScratchArena_t::Get(h+1);
+    ReciprocalLimbs(vh,&B[l],h,true);
+
+    // D=2^(64*(n+h))-B*Vh is the error of Vh at full width. It's under
+    // 2*2^(64*n) so it fits in n+1 limbs, keep the magnitude and the sign.
+    int64 *d=ScratchArena_t::Get(n+h+1);
+    MultiplyLimbsUnbalanced(d,B,n,vh,h+1);
+    NegateLimbs(d,n+h+1);
+    int64 one=1;
+    Add64(&d[n+h],&one,0);
+    int dnegative=(d[n+h]<0);
+    if (dnegative)
+    {
+        NegateLimbs(d,n+h+1);
+    }
+
+    // correction=Vh*D/2^(128*h), the bottom h-1 limbs of D only affect the
+    // last unit or so
+    const int dsize=l+3;
+    int64 *corr=ScratchArena_t::Get(h+1+dsize);
+    MultiplyLimbsUnbalanced(corr,vh,h+1,&d[h-1],dsize);
+
+    // V=Vh shifted up by l limbs, plus or minus the correction
+    for (int x=0;x<=n;x++)
+    {
+        V[x]=(x>=l)?vh[x-l]:0;
+    }
+    if (dnegative)
+    {
+        SubLimbsAt(V,n+1,0,&corr[h+1],dsize);
+    }
+    else
+    {
+        AddLimbsAt(V,n+1,0,&corr[h+1],dsize);
+    }
+    if (!Exact)
+    {
+        return;
+    }
+
+    // R=2^(128*n)-1-B*V must end up in [0,B)
+    const int width=2*n+2;
+    int64 *r=ScratchArena_t::GetZero(width);
+    int64 *t=ScratchArena_t::GetZero(width);
+    int64 *b=ScratchArena_t::GetZero(width);
+    MultiplyLimbsUnbalanced(t,V,n+1,B,n);
+    for (int x=0;x<2*n;x++)
+    {
+        r[x]=-1;
+    }
+    for (int x=0;x<n;x++)
+    {
+        b[x]=B[x];
+    }
+    SubLimbs(r,t,width,0);
+    while (r[width-1]<0)
+    {
+        SubLimbsAt(V,n+1,0,&one,1);
+        AddLimbs(r,b,width,0);
+    }
+    while (GreaterEqualLimbs(r,b,width))
+    {
+        AddLimbsAt(V,n+1,0,&one,1);
+        SubLimbs(r,b,width,0);
+    }
+}
+
+// One Barrett step. X is 2*Size limbs and less than B*2^(64*Size), V is the
+// reciprocal of B from above. Q=X/B (Size limbs) and R=X%B (Size limbs).
+// The estimate floor(floor(X/2^(64*(Size-1)))*V/2^(64*(Size+1))) is within a
+// few units of the real quotient, it's fixed up by adding or subtracting B.
+static inline void BarrettDivideLimbs(int64 *Q,int64 *R,const int64 *X,const int64 *B,const int64 *V,const int Size)
+{
+    const int n=Size;
+    const int width=2*n+2;
+    ScratchFrame_t frame;
+    int64 *q2=ScratchArena_t::Get(2*n+2);
+    int64 *t=ScratchArena_t::Get(width);
+    int64 *b=ScratchArena_t::Get(n+1);
+    int64 *rem=ScratchArena_t::Get(width);
+
+    // the estimate can overshoot into an extra limb
+    MultiplyLimbs(q2,&X[n-1],V,n+1);
+    int64 *q=&q2[n+1];
+    for (int x=0;x<n;x++)
+    {
+        b[x]=B[x];
+    }
+    b[n]=0;
+
+    // remainder=X-Q*B, two's complement over width limbs
+    MultiplyLimbs(t,q,b,n+1);
+    for (int x=0;x<2*n;x++)
+    {
+        rem[x]=X[x];
+    }
+    rem[2*n]=rem[2*n+1]=0;
+    SubLimbs(rem,t,width,0);
+    int64 one=1;
+    while (rem[width-1]<0)
+    {
+        AddLimbsAt(rem,width,0,b,n);
+        SubLimbsAt(q,n+1,0,&one,1);
+    }
+    // once it's positive it's only a few B so it fits in n+1 limbs
+    while (GreaterEqualLimbs(rem,b,n+1))
+    {
+        SubLimbsAt(rem,width,0,b,n);
+        AddLimbsAt(q,n+1,0,&one,1);
+    }
+    for (int x=0;x<n;x++)
+    {
+        Q[x]=q[x];
+        R[x]=rem[x];
+    }
+}
+
+// Q=A/B and R=A%B, all Size limbs, same contract as DivideLimbs.
+// The divisor is normalized, its reciprocal is computed once, then the
+// dividend is consumed from the top one divisor length "digit" at a time.
+static inline void DivideLimbsNewton(int64 *Q,int64 *R,const int64 *A,const int64 *B,const int Size)
+{
+    int n=Size;
+    while ((n>0) && (B[n-1]==0))
+    {
+        n--;
+    }
+    int m=Size;
+    while ((m>0) && (A[m-1]==0))
+    {
+        m--;
+    }
+    if ((n<DOUBLEINT_NEWTON_DIVIDE_LIMBS) || (m<n))
+    {
+        DivideLimbs(Q,R,A,B,Size);
+        return;
+    }
+
+    // normalize, the dividend gets an extra limb and is padded to whole digits
+    const int shift=CountLeadingZeros64(B[n-1]);
+    const int digits=(m+1+n-1)/n;
+    ScratchFrame_t frame;
+    int64 *b=ScratchArena_t::Get(n);
+    int64 *a=ScratchArena_t::GetZero(digits*n);
+    int64 *v=ScratchArena_t::Get(n+1);
+    for (int x=0;x<n;x++)
+    {
+        b[x]=B[x];
+    }
+    for (int x=0;x<m;x++)
+    {
+        a[x]=A[x];
+    }
+    ShiftLeftLimbs(b,n,shift);
+    ShiftLeftLimbs(a,m+1,shift);
+    ReciprocalLimbs(v,b,n,false);
+
+    for (int x=0;x<Size;x++)
+    {
+        Q[x]=0;
+        R[x]=0;
+    }
+    // x holds remainder:next digit, the remainder is always less than B.
+    // The top digit is usually shorter than B, skip the multiplies when it is.
+    int64 *x=ScratchArena_t::GetZero(2*n);
+    int64 *q=ScratchArena_t::Get(n);
+    for (int digit=digits-1;digit>=0;digit--)
+    {
+        for (int y=0;y<n;y++)
+        {
+            x[n+y]=x[y];
+            x[y]=a[digit*n+y];
+        }
+        bool empty=true;
+        for (int y=n;(y<2*n) && empty;y++)
+        {
+            empty=(x[y]==0);
+        }
+        if (empty && !GreaterEqualLimbs(x,b,n))
+        {
+            continue;
+        }
+        BarrettDivideLimbs(q,x,x,b,v,n);
+        for (int y=0;(y<n) && (digit*n+y<Size);y++)
+        {
+            Q[digit*n+y]=q[y];
+        }
+    }
+
+    ShiftRightLimbs(x,n,shift);
+    for (int y=0;y<n;y++)
+    {
+        R[y]=x[y];
+    }
+}
+
+// Repeated reduction by one modulus (Barrett's method, HAC 14.42). mu=2^(128*k)/m is
+// computed once, where k is the limb length of m. After that reducing anything
+// under m*2^(64*k) (a product of two values mod m for instance) is two multiplies and
+// at most a couple of subtracts of m. Only the top of the first product and the
+// bottom of the second are needed. Cutting the schoolbook rows short halves
+// them, which beats the full Toom-3 products until the modulus is about as big
+// as where divides switch to Newton. Both are also trimmed to the significant
+// limbs so a value that is only a little larger than m costs O(k).
+//
+//   BarrettReducer_t<int2048> red(m);
+//   int2048 lo=a;
+//   int2048 hi=int2048::MultiplyDouble(&lo,b);
+//   int2048 r=red.Reduce(hi,lo); // a*b mod m
+//   int2048 r2=red.Reduce(WideMultiply(a,b)); // same thing
+template<class IntT> class BarrettReducer_t
+{
+    public:
+        BarrettReducer_t(const IntT &Modulus);
+
+        IntT Reduce(const IntT &Hi,const IntT &Lo);
+        IntT Reduce(const DoubleInt_t<IntT> &A);
+        IntT Reduce(const IntT &A);
+        void ReduceN(IntT *Values,const int Count);
+//  private:
+        void ReduceStep(int64 *R,const int64 *X,const int XSize);
+        void ReduceLimbs(int64 *R,const int64 *A,const int ASize);
+        static const int limbs=IntT::limbs;
+        int k;                     // significant limbs in the modulus
+        std::vector<int64> m;      // k limbs
+        std::vector<int64> mu;     // floor(2^(128*k)/m), k+2 limbs
+        std::vector<int64> q,t,r,step,rem;
+};
+
+
+template<class IntT> BarrettReducer_t<IntT>::BarrettReducer_t(const IntT &Modulus)
+{
+    int64 modulus[limbs];
+    IntT::GetLimbs(Modulus,modulus);
+    k=limbs;
+    while ((k>0) && (modulus[k-1]==0))
+    {
+        k--;
+    }
+    if (k==0)
+    {
+        throw "division by zero";
+    }
+    m.assign(modulus,modulus+k);
+
+    std::vector<int64> num(2*k+2,0),div(2*k+2,0),quotient(2*k+2),remainder(2*k+2);
+    num[2*k]=1;
+    for (int y=0;y<k;y++)
+    {
+        div[y]=m[y];
+    }
+    DivideLimbsNewton(&quotient[0],&remainder[0],&num[0],&div[0],2*k+2);
+    mu.assign(&quotient[0],&quotient[k+2]);
+
+    q.resize(k+2);
+    t.resize(3*k+4);
+    r.resize(k+1);
+    step.resize(2*k);
+    rem.resize(k);
+}
+
+// R(k limbs)=X%m where X is XSize<=2*k limbs
+template<class IntT> void BarrettReducer_t<IntT>::ReduceStep(int64 *R,const int64 *X,const int XSize)
+{
+    int len=XSize;
+    while ((len>0) && (X[len-1]==0))
+    {
+        len--;
+    }
+    if (len<k)
+    {
+        for (int y=0;y<k;y++)
+        {
+            R[y]=(y<len)?X[y]:0;
+        }
+        return;
+    }
+
+    // q3=floor(floor(X/2^(64*(k-1)))*mu/2^(64*(k+1))), which is at most 2 under X/m
+    // (3 with the truncated product)
+    const int64 *q1=&X[k-1];
+    const int q1len=len-(k-1);
+    const int mulen=k+2;
+    for (int y=0;y<q1len+mulen;y++)
+    {
+        t[y]=0;
+    }
+    if (k<DOUBLEINT_NEWTON_DIVIDE_LIMBS)
+    {
+        // products landing below limb k-1 can't carry more than a unit into limb k+1
+        for (int i=0;i<q1len;i++)
+        {
+            int start=k-1-i;
+            if (start<0)
+            {
+                start=0;
+            }
+            if (start>=mulen)
+            {
+                continue;
+            }
+            t[i+mulen]=AddMulLimb(&t[i+start],&mu[start],mulen-start,q1[i]);
+        }
+    }
+    else
+    {
+        MultiplyLimbsUnbalanced(&t[0],q1,q1len,&mu[0],mulen);
+    }
+    int q3len=q1len+mulen-(k+1);
+    while ((q3len>0) && (t[k+1+q3len-1]==0))
+    {
+        q3len--;
+    }
+    if (q3len>k+1)
+    {
+        q3len=k+1;
+    }
+    int64 *q3=&q[0];
+    for (int y=0;y<q3len;y++)
+    {
+        q3[y]=t[k+1+y];
+    }
+
+    // r=(X-q3*m) mod 2^(64*(k+1))
+    for (int y=0;y<=k;y++)
+    {
+        r[y]=(y<len)?X[y]:0;
+    }
+    if (k<DOUBLEINT_NEWTON_DIVIDE_LIMBS)
+    {
+        for (int y=0;y<=k;y++)
+        {
+            t[y]=0;
+        }
+        for (int i=0;i<q3len;i++)
+        {
+            int rowlen=k+1-i;
+            if (rowlen>k)
+            {
+                rowlen=k;
+            }
+            int64 carry=AddMulLimb(&t[i],&m[0],rowlen,q3[i]);
+            if (i+rowlen<=k)
+            {
+                t[i+rowlen]=carry;
+            }
+        }
+    }
+    else if (q3len>0)
+    {
+        MultiplyLimbsUnbalanced(&t[0],q3,q3len,&m[0],k);
+    }
+    else
+    {
+        for (int y=0;y<=k;y++)
+        {
+            t[y]=0;
+        }
+    }
+    SubLimbs(&r[0],&t[0],k+1,0);
+    while ((r[k]!=0) || GreaterEqualLimbs(&r[0],&m[0],k))
+    {
+        r[k]-=SubLimbs(&r[0],&m[0],k,0);
+    }
+    for (int y=0;y<k;y++)
+    {
+        R[y]=r[y];
+    }
+}
+
+// R(limbs long)=A%m. Inputs longer than 2*k are taken k limbs at a time from
+// the top, the running remainder stays under m so remainder:chunk is always
+// under 4^k.
+template<class IntT> void BarrettReducer_t<IntT>::ReduceLimbs(int64 *R,const int64 *A,const int ASize)
+{
+    int chunks=(ASize>2*k)?(ASize-k-1)/k:0;
+    ReduceStep(&rem[0],&A[chunks*k],ASize-chunks*k);
+    for (int chunk=chunks-1;chunk>=0;chunk--)
+    {
+        for (int y=0;y<k;y++)
+        {
+            step[y]=A[chunk*k+y];
+            step[k+y]=rem[y];
+        }
+        ReduceStep(&rem[0],&step[0],2*k);
+    }
+    for (int y=0;y<limbs;y++)
+    {
+        R[y]=(y<k)?rem[y]:0;
+    }
+}
+
+// (Hi*2^N+Lo)%m, where Hi:Lo is what MultiplyDouble returns:leaves in A
+template<class IntT> IntT BarrettReducer_t<IntT>::Reduce(const IntT &Hi,const IntT &Lo)
+{
+    IntT ret;
+    int64 a[2*limbs],res[limbs];
+    IntT::GetLimbs(Lo,a);
+    IntT::GetLimbs(Hi,&a[limbs]);
+    ReduceLimbs(res,a,2*limbs);
+    IntT::SetLimbs(&ret,res);
+    return ret;
+}
+
+// a WideMultiply product is already the 2*limbs array, no copy needed
+template<class IntT> IntT BarrettReducer_t<IntT>::Reduce(const DoubleInt_t<IntT> &A)
+{
+    IntT ret;
+    int64 res[limbs];
+    ReduceLimbs(res,DoubleInt_t<IntT>::LimbPtr(A),2*limbs);
+    IntT::SetLimbs(&ret,res);
+    return ret;
+}
+
+template<class IntT> IntT BarrettReducer_t<IntT>::Reduce(const IntT &A)
+{
+    IntT ret;
+    int64 a[limbs],res[limbs];
+    IntT::GetLimbs(A,a);
+    ReduceLimbs(res,a,limbs);
+    IntT::SetLimbs(&ret,res);
+    return ret;
+}
+
+// Values[x]%=m for the whole array
+template<class IntT> void BarrettReducer_t<IntT>::ReduceN(IntT *Values,const int Count)
+{
+    int64 a[limbs],res[limbs];
+    for (int y=0;y<Count;y++)
+    {
+        IntT::GetLimbs(Values[y],a);
+        ReduceLimbs(res,a,limbs);
+        IntT::SetLimbs(&Values[y],res);
+    }
+}
+
+#endif //FASTDIVIDE_HPP
@@ -0,0 +1,650 @@
+// C++ BigNum template class
+// AKA the integer doubler template.
+// Copyright(C) 2007,2015 Jeremy Linton
+//
+// Source identity: FastMultiply.hpp
+//
+// The nested doubler multiply is at best Karatsuba, which is fine up to
+// a few thousand bits. Past that the recursion simply does too many small
+// multiplies. This module provides Toom-3 and a number theoretic transform
+// (FFT over a prime field) multiply which work on flat limb arrays (least
+// significant limb first, see GetLimbs/SetLimbs). DoubleInt_t::MultiplyDouble
+// copies its operands out to flat arrays and calls MultiplyLimbs() once the
+// type is DOUBLEINT_FLAT_MULTIPLY_BITS or wider.
+//
+// See DoubleInt_t.hpp for more information
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+// USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef FASTMULTIPLY_HPP
+#define FASTMULTIPLY_HPP
+
+#include "int128_t.hpp"
+
+// Toom-3 splits into thirds until the operands are shorter than this many
+// limbs, then falls back to the grade school multiply.
+#ifndef DOUBLEINT_TOOM3_LIMBS
+#define DOUBLEINT_TOOM3_LIMBS 48
+#endif
+
+// same idea for squares, the grade school square does half the work so it
+// holds out longer
+#ifndef DOUBLEINT_TOOM3_SQUARE_LIMBS
+#define DOUBLEINT_TOOM3_SQUARE_LIMBS 64
+#endif
+
+// operands this many limbs or longer go through the NTT instead of Toom-3
+#ifndef DOUBLEINT_NTT_LIMBS
+#define DOUBLEINT_NTT_LIMBS 16384
+#endif
+
+
+static inline void MultiplyLimbs(int64 *R,const int64 *A,const int64 *B,const int Size);
+static inline void SquareLimbs(int64 *R,const int64 *A,const int Size);
+
+
+//
+//
+//          Toom-3
+//
+//
+
+// Two's complement negate over Size limbs
+static inline void NegateLimbs(int64 *A,const int Size)
+{
+    int carry=1;
+    int64 zero=0;
+    for (int x=0;x<Size;x++)
+    {
+        A[x]=~A[x];
+        carry=Add64(&A[x],&zero,carry);
+    }
+}
+
+// A>=B for two unsigned Size limb values
+static inline bool GreaterEqualLimbs(const int64 *A,const int64 *B,const int Size)
+{
+    for (int x=Size-1;x>=0;x--)
+    {
+        if (A[x]!=B[x])
+        {
+            return ((uint64)A[x]>(uint64)B[x]);
+        }
+    }
+    return true;
+}
+
+// R+=A at limb offset, A is Size limbs but only the part below RSize is added
+static inline void AddLimbsAt(int64 *R,const int RSize,const int Offset,const int64 *A,const int Size)
+{
+    int len=Size;
+    if (Offset+len>RSize)
+    {
+        len=RSize-Offset;
+    }
+    int carry=AddLimbs(&R[Offset],A,len,0);
+    int64 zero=0;
+    for (int x=Offset+len;(x<RSize) && carry;x++)
+    {
+        carry=Add64(&R[x],&zero,carry);
+    }
+}
+
+// R-=A at limb offset, same truncation as AddLimbsAt. Returns the borrow out the top.
+static inline int SubLimbsAt(int64 *R,const int RSize,const int Offset,const int64 *A,const int Size)
+{
+    int len=Size;
+    if (Offset+len>RSize)
+    {
+        len=RSize-Offset;
+    }
+    int borrow=SubLimbs(&R[Offset],A,len,0);
+    int64 zero=0;
+    for (int x=Offset+len;(x<RSize) && borrow;x++)
+    {
+        borrow=Sub64(&R[x],&zero,borrow);
+    }
+    return borrow;
+}
+
+// Evaluate the 3 part polynomial a2*x^2+a1*x+a0 (x=2^(64*Part)) at 1, -1 and 2.
+// Each result is Part+1 limbs, the value at -1 is returned as a magnitude and a sign.
+static inline void Toom3Evaluate(const int64 *A,const int Size,const int Part,int64 *P1,int64 *Pm1,int *Pm1Negative,int64 *P2)
+{
+    const int64 *a0=A;
+    const int64 *a2=&A[2*Part];
+    const int    a2size=Size-2*Part;
+    ScratchFrame_t frame;
+    int64 *a1=ScratchArena_t::Get(Part+1);
+
+    for (int x=0;x<Part;x++)
+    {
+        a1[x]=A[Part+x];
+    }
+    a1[Part]=0;
+    for (int x=0;x<=Part;x++)
+    {
+        P1[x]=(x<Part)?a0[x]:0;
+        P2[x]=(x<a2size)?a2[x]:0;
+    }
+
+    // P1=a0+a2
+    AddLimbsAt(P1,Part+1,0,a2,a2size);
+
+    // Pm1=|a0+a2-a1|
+    if (GreaterEqualLimbs(P1,a1,Part+1))
+    {
+        for (int x=0;x<=Part;x++)
+        {
+            Pm1[x]=P1[x];
+        }
+        SubLimbs(Pm1,a1,Part+1,0);
+        *Pm1Negative=0;
+    }
+    else
+    {
+        for (int x=0;x<=Part;x++)
+        {
+            Pm1[x]=a1[x];
+        }
+        SubLimbs(Pm1,P1,Part+1,0);
+        *Pm1Negative=1;
+    }
+
+    // P1=a0+a1+a2
+    AddLimbs(P1,a1,Part+1,0);
+
+    // P2=((a2*2)+a1)*2+a0
+    ShiftLeftLimbs(P2,Part+1,1);
+    AddLimbs(P2,a1,Part+1,0);
+    ShiftLeftLimbs(P2,Part+1,1);
+    AddLimbsAt(P2,Part+1,0,a0,Part);
+}
+
+// Given r(0) and r(inf) already in R, and r(1), r(-1), r(2) (each width limbs, two's
+// complement) interpolate the three middle coefficients and add them into R.
+// Clobbers R1, Rm1 and R2.
+static inline void Toom3Interpolate(int64 *R,const int Size,const int Part,int64 *R1,int64 *Rm1,int64 *R2)
+{
+    const int topsize=Size-2*Part;
+    const int width=2*(Part+1)+1;
+
+    ScratchFrame_t frame;
+    int64 *r0=ScratchArena_t::GetZero(width);
+    int64 *rinf=ScratchArena_t::GetZero(width);
+    for (int x=0;x<2*Part;x++)
+    {
+        r0[x]=R[x];
+    }
+    for (int x=0;x<2*topsize;x++)
+    {
+        rinf[x]=R[4*Part+x];
+    }
+
+    // interpolation (Bodrato's sequence for the points 0,1,-1,2,inf)
+    // r3=(r(2)-r(-1))/3
+    int64 *r3=R2;
+    SubLimbs(r3,Rm1,width,0);
+    DivideLimbsByLimb(r3,width,3);
+    // r1=(r(1)-r(-1))/2
+    SubLimbs(R1,Rm1,width,0);
+    ShiftRightLimbs(R1,width,1);
+    // r2=r(-1)-r(0)
+    int64 *c2=Rm1;
+    SubLimbs(c2,r0,width,0);
+    // r3=(r3-r2)/2-2*r(inf)
+    SubLimbs(r3,c2,width,0);
+    ShiftRightLimbs(r3,width,1);
+    SubLimbs(r3,rinf,width,0);
+    SubLimbs(r3,rinf,width,0);
+    // r2=r2+r1-r(inf)
+    AddLimbs(c2,R1,width,0);
+    SubLimbs(c2,rinf,width,0);
+    // r3=r3-r1 and r1=r1-r3
+    SubLimbs(r3,R1,width,0);
+    SubLimbs(R1,r3,width,0);
+
+    // all three middle coefficients are positive now, add them in
+    AddLimbsAt(R,2*Size,Part,R1,width);
+    AddLimbsAt(R,2*Size,2*Part,c2,width);
+    AddLimbsAt(R,2*Size,3*Part,r3,width);
+}
+
+// R[0..2*Size)=A*B, Size must be at least 3
+static inline void MultiplyLimbsToom3(int64 *R,const int64 *A,const int64 *B,const int Size)
+{
+    const int part=(Size+2)/3;
+    const int topsize=Size-2*part;
+    const int evalsize=part+1;
+    const int width=2*evalsize+1; //interpolation width, two's complement
+    int am1neg,bm1neg;
+
+    ScratchFrame_t frame;
+    int64 *ap1=ScratchArena_t::Get(evalsize);
+    int64 *am1=ScratchArena_t::Get(evalsize);
+    int64 *ap2=ScratchArena_t::Get(evalsize);
+    int64 *bp1=ScratchArena_t::Get(evalsize);
+    int64 *bm1=ScratchArena_t::Get(evalsize);
+    int64 *bp2=ScratchArena_t::Get(evalsize);
+    int64 *r1=ScratchArena_t::Get(width);
+    int64 *rm1=ScratchArena_t::Get(width);
+    int64 *r2=ScratchArena_t::Get(width);
+
+    Toom3Evaluate(A,Size,part,ap1,am1,&am1neg,ap2);
+    Toom3Evaluate(B,Size,part,bp1,bm1,&bm1neg,bp2);
+
+    // r(0) and r(inf) go straight into the result
+    for (int x=2*part;x<4*part;x++)
+    {
+        R[x]=0;
+    }
+    MultiplyLimbs(R,A,B,part);
+    MultiplyLimbs(&R[4*part],&A[2*part],&B[2*part],topsize);
+
+    MultiplyLimbs(r1,ap1,bp1,evalsize);
+    MultiplyLimbs(rm1,am1,bm1,evalsize);
+    MultiplyLimbs(r2,ap2,bp2,evalsize);
+    r1[width-1]=rm1[width-1]=r2[width-1]=0;
+    if (am1neg^bm1neg)
+    {
+        NegateLimbs(rm1,width);
+    }
+
+    Toom3Interpolate(R,Size,part,r1,rm1,r2);
+}
+
+// R[0..2*Size)=A*A, same as above but one evaluation and five squares.
+// r(-1) is a square so it can't be negative.
+static inline void SquareLimbsToom3(int64 *R,const int64 *A,const int Size)
+{
+    const int part=(Size+2)/3;
+    const int topsize=Size-2*part;
+    const int evalsize=part+1;
+    const int width=2*evalsize+1;
+    int am1neg;
+
+    ScratchFrame_t frame;
+    int64 *ap1=ScratchArena_t::Get(evalsize);
+    int64 *am1=ScratchArena_t::Get(evalsize);
+    int64 *ap2=ScratchArena_t::Get(evalsize);
+    int64 *r1=ScratchArena_t::Get(width);
+    int64 *rm1=ScratchArena_t::Get(width);
+    int64 *r2=ScratchArena_t::Get(width);
+
+    Toom3Evaluate(A,Size,part,ap1,am1,&am1neg,ap2);
+
+    for (int x=2*part;x<4*part;x++)
+    {
+        R[x]=0;
+    }
+    SquareLimbs(R,A,part);
+    SquareLimbs(&R[4*part],&A[2*part],topsize);
+
+    SquareLimbs(r1,ap1,evalsize);
+    SquareLimbs(rm1,am1,evalsize);
+    SquareLimbs(r2,ap2,evalsize);
+    r1[width-1]=rm1[width-1]=r2[width-1]=0;
+
+    Toom3Interpolate(R,Size,part,r1,rm1,r2);
+}
+
+
+//
+//
+//          NTT
+//
+// The transform is done modulo the prime 2^64-2^32+1 which has roots of unity
+// for every power of two up to 2^32 and a cheap reduction. Each 64-bit limb is
+// split into four 16-bit digits, so a convolution column is at most
+// 2^32*(number of digits) which stays well under the prime for any length
+// we can build.
+//
+
+static const uint64 NTT_PRIME=0xFFFFFFFF00000001ULL;
+static const uint64 NTT_EPSILON=0xFFFFFFFFULL; // 2^64 mod NTT_PRIME
+
+// hi:lo mod NTT_PRIME, uses 2^64=2^32-1 and 2^96=-1
+static inline uint64 NttReduce(const uint64 hi,const uint64 lo)
+{
+    uint64 hihi=hi>>32;
+    uint64 hilo=hi&NTT_EPSILON;
+    uint64 t0=lo-hihi;
+    if (lo<hihi)
+    {
+        t0-=NTT_EPSILON;
+    }
+    uint64 t1=hilo*NTT_EPSILON;
+    uint64 ret=t0+t1;
+    if (ret<t1)
+    {
+        ret+=NTT_EPSILON;
+    }
+    if (ret>=NTT_PRIME)
+    {
+        ret-=NTT_PRIME;
+    }
+    return ret;
+}
+
+static inline uint64 NttMultiply(const uint64 A,const uint64 B)
+{
+    int64 lo=A;
+    int64 b=B;
+    int64 hi=Multiply64(&lo,&b);
+    return NttReduce(hi,lo);
+}
+
+static inline uint64 NttAdd(const uint64 A,const uint64 B)
+{
+    uint64 ret=A+B;
+    if ((ret<A) || (ret>=NTT_PRIME))
+    {
+        ret-=NTT_PRIME;
+    }
+    return ret;
+}
+
+static inline uint64 NttSub(const uint64 A,const uint64 B)
+{
+    uint64 ret=A-B;
+    if (A<B)
+    {
+        ret+=NTT_PRIME;
+    }
+    return ret;
+}
+
+static inline uint64 NttPower(uint64 Base,uint64 Exp)
+{
+    uint64 ret=1;
+    while (Exp)
+    {
+        if (Exp&1)
+        {
+            ret=NttMultiply(ret,Base);
+        }
+        Base=NttMultiply(Base,Base);
+        Exp>>=1;
+    }
+    return ret;
+}
+
+// in place iterative radix 2 transform, Size must be a power of two
+static inline void NttTransform(uint64 *Data,const int Size,const bool Inverse)
+{
+    // bit reversal
+    for (int x=1,y=0;x<Size;x++)
+    {
+        int bit=Size>>1;
+        for (;y&bit;bit>>=1)
+        {
+            y^=bit;
+        }
+        y^=bit;
+        if (x<y)
+        {
+            uint64 tmp=Data[x];
+            Data[x]=Data[y];
+            Data[y]=tmp;
+        }
+    }
+
+    // 7 generates the multiplicative group
+    uint64 root=NttPower(7,(NTT_PRIME-1)/Size);
+    if (Inverse)
+    {
+        root=NttPower(root,NTT_PRIME-2);
+    }
+    ScratchFrame_t frame;
+    uint64 *twiddle=(uint64 *)ScratchArena_t::Get(Size/2>0?Size/2:1);
+    twiddle[0]=1;
+    for (int x=1;x<Size/2;x++)
+    {
+        twiddle[x]=NttMultiply(twiddle[x-1],root);
+    }
+
+    for (int len=2;len<=Size;len<<=1)
+    {
+        int half=len>>1;
+        int step=Size/len;
+        for (int x=0;x<Size;x+=len)
+        {
+            for (int y=0;y<half;y++)
+            {
+                uint64 u=Data[x+y];
+                uint64 v=NttMultiply(Data[x+y+half],twiddle[y*step]);
+                Data[x+y]=NttAdd(u,v);
+                Data[x+y+half]=NttSub(u,v);
+            }
+        }
+    }
+
+    if (Inverse)
+    {
+        uint64 scale=NttPower(Size,NTT_PRIME-2);
+        for (int x=0;x<Size;x++)
+        {
+            Data[x]=NttMultiply(Data[x],scale);
+        }
+    }
+}
+
+// R[0..2*Size)=A*B through the NTT, squares only need one forward transform
+static inline void MultiplyLimbsNtt(int64 *R,const int64 *A,const int64 *B,const int Size)
+{
+    const int digits=Size*4;
+    int len=1;
+    while (len<2*digits)
+    {
+        len<<=1;
+    }
+
+    ScratchFrame_t frame;
+    uint64 *fa=(uint64 *)ScratchArena_t::GetZero(len);
+    for (int x=0;x<digits;x++)
+    {
+        fa[x]=((uint64)A[x>>2]>>((x&3)*16))&0xFFFF;
+    }
+    NttTransform(fa,len,false);
+    if (A==B)
+    {
+        for (int x=0;x<len;x++)
+        {
+            fa[x]=NttMultiply(fa[x],fa[x]);
+        }
+    }
+    else
+    {
+        uint64 *fb=(uint64 *)ScratchArena_t::GetZero(len);
+        for (int x=0;x<digits;x++)
+        {
+            fb[x]=((uint64)B[x>>2]>>((x&3)*16))&0xFFFF;
+        }
+        NttTransform(fb,len,false);
+        for (int x=0;x<len;x++)
+        {
+            fa[x]=NttMultiply(fa[x],fb[x]);
+        }
+    }
+    NttTransform(fa,len,true);
+
+    // carry the 16-bit columns back into limbs
+    uint64 carry=0;
+    for (int x=0;x<Size*2;x++)
+    {
+        uint64 limb=0;
+        for (int y=0;y<4;y++)
+        {
+            carry+=fa[x*4+y];
+            limb|=(carry&0xFFFF)<<(y*16);
+            carry>>=16;
+        }
+        R[x]=limb;
+    }
+}
+
+
+//
+//
+//          Comba
+//
+//
+
+// (c2:c1:c0)+=A*B, one step of a column sum
+static inline void CombaStep(int64 *c0,int64 *c1,int64 *c2,int64 A,const int64 &B)
+{
+    int64 hi;
+    asm ("mulq %[b]          \n\t"
+         "add %%rax, %[c0]   \n\t"
+         "adc %%rdx, %[c1]   \n\t"
+         "adc $0, %[c2]      \n\t"
+         : [c0] "+r" (*c0), [c1] "+r" (*c1), [c2] "+r" (*c2), "+a" (A), "=&d" (hi)
+         : [b] "m" (B)
+         : "cc"
+        );
+}
+
+// R[0..2*Size)=A*B a column at a time (product scanning). Every A[x]*B[y]
+// with x+y==column is summed into a three limb accumulator that stays in
+// registers, then the column is written out once and the accumulator
+// shifts down a limb. Size is a template parameter so both loops unroll
+// completely, only use it for a few dozen limbs at most.
+template<int Size> static inline void MultiplyLimbsComba(int64 *R,const int64 *A,const int64 *B)
+{
+    int64 c0=0,c1=0,c2=0;
+#pragma GCC unroll 64
+    for (int col=0;col<2*Size-1;col++)
+    {
+#pragma GCC unroll 64
+        for (int x=((col<Size)?0:col-Size+1);x<=((col<Size)?col:Size-1);x++)
+        {
+            CombaStep(&c0,&c1,&c2,A[x],B[col-x]);
+        }
+        R[col]=c0;
+        c0=c1;
+        c1=c2;
+        c2=0;
+    }
+    R[2*Size-1]=c0;
+}
+
+// R[0..2*Size)=A*B, picks the method based on the operand length
+static inline void MultiplyLimbs(int64 *R,const int64 *A,const int64 *B,const int Size)
+{
+    if (Size>=DOUBLEINT_NTT_LIMBS)
+    {
+        MultiplyLimbsNtt(R,A,B,Size);
+    }
+    else if (Size>=DOUBLEINT_TOOM3_LIMBS)
+    {
+        MultiplyLimbsToom3(R,A,B,Size);
+    }
+    else
+    {
+        MultiplyLimbsBasecase(R,A,Size,B,Size);
+    }
+}
+
+// R[0..2*Size)=A*A
+static inline void SquareLimbs(int64 *R,const int64 *A,const int Size)
+{
+    if (Size>=DOUBLEINT_NTT_LIMBS)
+    {
+        MultiplyLimbsNtt(R,A,A,Size);
+    }
+    else if (Size>=DOUBLEINT_TOOM3_SQUARE_LIMBS)
+    {
+        SquareLimbsToom3(R,A,Size);
+    }
+    else
+    {
+        SquareLimbsBasecase(R,A,Size);
+    }
+}
+
+// R[0..2*Size)=A+B*C where A is Size limbs (and may be R). Below the Toom-3
+// threshold the rows of B*C are added straight onto A, so the accumulator is
+// only walked once. Above it the product is cheaper on its own and A is added
+// in afterwards.
+static inline void AddMulLimbs(int64 *R,const int64 *A,const int64 *B,const int64 *C,const int Size)
+{
+    if (Size>=DOUBLEINT_TOOM3_LIMBS)
+    {
+        ScratchFrame_t frame;
+        int64 *p=ScratchArena_t::Get(2*Size);
+        MultiplyLimbs(p,B,C,Size);
+        AddLimbsAt(p,2*Size,0,A,Size);
+        for (int x=0;x<2*Size;x++)
+        {
+            R[x]=p[x];
+        }
+        return;
+    }
+    for (int x=0;x<Size;x++)
+    {
+        R[x]=A[x];
+    }
+    // each row's carry limb lands above everything the earlier rows wrote
+    for (int x=0;x<Size;x++)
+    {
+        R[Size+x]=AddMulLimb(&R[x],B,Size,C[x]);
+    }
+}
+
+// R[0..Size)=A-B*C (mod 2^(64*Size)) and R[Size..2*Size) is how much that
+// borrowed from above, so A-B*C=R.lo-R.hi*2^(64*Size). Same one pass as
+// AddMulLimbs, each row's borrow limb is kept to one side and they're all
+// taken off the top half at the end.
+static inline void SubMulLimbs(int64 *R,const int64 *A,const int64 *B,const int64 *C,const int Size)
+{
+    ScratchFrame_t frame;
+    if (Size>=DOUBLEINT_TOOM3_LIMBS)
+    {
+        int64 *p=ScratchArena_t::Get(2*Size);
+        MultiplyLimbs(p,B,C,Size);
+        for (int x=0;x<Size;x++)
+        {
+            R[x]=A[x];
+        }
+        int64 borrow=SubLimbs(R,p,Size,0);
+        AddLimbsAt(&p[Size],Size,0,&borrow,1);
+        for (int x=0;x<Size;x++)
+        {
+            R[Size+x]=p[Size+x];
+        }
+        return;
+    }
+    int64 *borrows=ScratchArena_t::Get(Size);
+    for (int x=0;x<Size;x++)
+    {
+        R[x]=A[x];
+        R[Size+x]=0;
+    }
+    for (int x=0;x<Size;x++)
+    {
+        borrows[x]=SubMulLimb(&R[x],B,Size,C[x]);
+    }
+    // what's above Size is -(borrows-R.hi)
+    SubLimbs(borrows,&R[Size],Size,0);
+    for (int x=0;x<Size;x++)
+    {
+        R[Size+x]=borrows[x];
+    }
+}
+
+#endif //FASTMULTIPLY_HPP
@@ -0,0 +1,433 @@
+// C++ BigNum template class
+// AKA the integer doubler template.
+// Copyright(C) 2007,2015 Jeremy Linton
+//
+// Source identity: FixedInt_t.hpp
+//
+// A fixed width unsigned integer stored as one flat array of N limbs, least
+// significant limb first. It has the same static interface as int128_t
+// (AddDouble, MultiplyDouble, DivideDouble, shiftleft, GetLimbs...) so it can
+// be used by itself or as the base class for the doubler:
+//
+//   typedef class FixedInt_t<4>               fint256;
+//   typedef class DoubleInt_t<FixedInt_t<4> > fint512;
+//   typedef class SignedInt_t<FixedInt_t<8> > sfint512;
+//
+// The nested Hi/Lo classes scatter the limbs (and the size fields) through
+// memory, here they are contiguous so the limb helpers in int128_t.hpp,
+// FastMultiply.hpp and FastDivide.hpp work on the value in place rather
+// than on a GetLimbs() copy.
+//
+// See DoubleInt_t.hpp for more information
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+// USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef FIXEDINT_T_HPP
+#define FIXEDINT_T_HPP
+
+#include <utility>
+#include "int128_t.hpp"
+#include "FastMultiply.hpp"
+#include "FastDivide.hpp"
+#include "HeapInt_t.hpp"
+
+// Widths up to this many limbs get their add/subtract carry chains fully
+// unrolled, past it the AddLimbs/SubLimbs loops are used.
+#ifndef DOUBLEINT_UNROLL_LIMBS
+#define DOUBLEINT_UNROLL_LIMBS 16
+#endif
+
+
+// A+=B over exactly N limbs. The assembler (.rept) unrolls the chain, so
+// there isn't any loop overhead and the carry never leaves CF.
+template<int N> static inline int AddLimbsUnrolled(int64 *A,const int64 *B,const int carry)
+{
+    int64 carry_io=carry;
+    int64 tmp;
+    asm volatile ("add $-1, %[carry]                 \n\t"
+         ".set .Lfixoffset, 0                \n\t"
+         ".rept %c[n]                        \n\t"
+         "mov .Lfixoffset(%[a]), %[tmp]      \n\t"
+         "adc .Lfixoffset(%[b]), %[tmp]      \n\t"
+         "mov %[tmp], .Lfixoffset(%[a])      \n\t"
+         ".set .Lfixoffset, .Lfixoffset+8    \n\t"
+         ".endr                              \n\t"
+         "sbb %[carry], %[carry]             \n\t"
+         : [carry] "+&r" (carry_io), [tmp] "=&r" (tmp)
+         : [a] "r" (A), [b] "r" (B), [n] "i" (N)
+         : "cc", "memory"
+        );
+    return (int)-carry_io;
+}
+
+// A-=B over exactly N limbs, returns the borrow
+template<int N> static inline int SubLimbsUnrolled(int64 *A,const int64 *B,const int borrow)
+{
+    int64 borrow_io=borrow;
+    int64 tmp;
+    asm volatile ("add $-1, %[borrow]                \n\t"
+         ".set .Lfixoffset, 0                \n\t"
+         ".rept %c[n]                        \n\t"
+         "mov .Lfixoffset(%[a]), %[tmp]      \n\t"
+         "sbb .Lfixoffset(%[b]), %[tmp]      \n\t"
+         "mov %[tmp], .Lfixoffset(%[a])      \n\t"
+         ".set .Lfixoffset, .Lfixoffset+8    \n\t"
+         ".endr                              \n\t"
+         "sbb %[borrow], %[borrow]           \n\t"
+         : [borrow] "+&r" (borrow_io), [tmp] "=&r" (tmp)
+         : [a] "r" (A), [b] "r" (B), [n] "i" (N)
+         : "cc", "memory"
+        );
+    return (int)-borrow_io;
+}
+
+
+template<int N> class FixedInt_t
+{
+    public:
+        // construction/casting
+        constexpr FixedInt_t()            :Limb{} {}
+        FixedInt_t(const FixedInt_t &orig)=default;
+        constexpr FixedInt_t(const int64 &orig):Limb{} { Limb[0]=orig;}
+        // assignment
+        FixedInt_t &operator= (const FixedInt_t &rhs)=default;
+        // compariston, the value is unsigned
+        bool     operator==(const FixedInt_t &rhs) const { return Compare(*this,rhs)==0;}
+        bool     operator!=(const FixedInt_t &rhs) const { return Compare(*this,rhs)!=0;}
+        bool     operator>=(const FixedInt_t &rhs) const { return Compare(*this,rhs)>=0;}
+        bool     operator<=(const FixedInt_t &rhs) const { return Compare(*this,rhs)<=0;}
+        bool     operator> (const FixedInt_t &rhs) const { return Compare(*this,rhs)>0;}
+        bool     operator< (const FixedInt_t &rhs) const { return Compare(*this,rhs)<0;}
+        // operations (these are exported for user use)
+        FixedInt_t &operator>>=(const int      rhs)  { shiftrightn(this,rhs); return *this;}
+        FixedInt_t &operator<<=(const int      rhs)  { shiftleftn(this,rhs); return *this;}
+        FixedInt_t &operator-=( const FixedInt_t &rhs) { SubDouble(this,rhs,0); return *this;}
+        FixedInt_t &operator+=( const FixedInt_t &rhs) { AddDouble(this,rhs,0); return *this;}
+        FixedInt_t &operator*=( const FixedInt_t &rhs) { MultiplyLow(this,rhs); return *this;}
+        FixedInt_t &operator/=( const FixedInt_t &rhs) { DivideDouble(this,rhs); return *this;}
+        FixedInt_t &operator%=( const FixedInt_t &rhs) { *this=DivideDouble(this,rhs); return *this;}
+
+        FixedInt_t &operator&=( const int64 &rhs) { Limb[0]&=rhs; return *this;}
+        FixedInt_t &operator|=( const int64 &rhs) { Limb[0]|=rhs; return *this;}
+        FixedInt_t &operator^=( const int64 &rhs) { Limb[0]^=rhs; return *this;}
+
+        FixedInt_t &operator&=( const FixedInt_t &rhs) { for (int x=0;x<N;x++) Limb[x]&=rhs.Limb[x]; return *this;}
+        FixedInt_t &operator|=( const FixedInt_t &rhs) { for (int x=0;x<N;x++) Limb[x]|=rhs.Limb[x]; return *this;}
+        FixedInt_t &operator^=( const FixedInt_t &rhs) { for (int x=0;x<N;x++) Limb[x]^=rhs.Limb[x]; return *this;}
+
+        FixedInt_t operator+(   const FixedInt_t &rhs) & { FixedInt_t tmp=*this; AddDouble(&tmp,rhs,0); return tmp;}
+        FixedInt_t operator-(   const FixedInt_t &rhs) & { FixedInt_t tmp=*this; SubDouble(&tmp,rhs,0); return tmp;}
+        FixedInt_t operator/(   const FixedInt_t &rhs) & { FixedInt_t tmp=*this; DivideDouble(&tmp,rhs); return tmp;}
+        FixedInt_t operator%(   const FixedInt_t &rhs) & { FixedInt_t tmp=*this; tmp=DivideDouble(&tmp,rhs); return tmp;}
+        FixedInt_t operator*(   const FixedInt_t &rhs) & { FixedInt_t tmp=*this; MultiplyLow(&tmp,rhs); return tmp;}
+        FixedInt_t Square() { FixedInt_t tmp=*this; SquareDouble(&tmp); return tmp;}
+
+        FixedInt_t operator&(   const int64    &rhs) & { FixedInt_t tmp=*this; tmp&=rhs; return tmp;}
+        FixedInt_t operator|(   const int64    &rhs) & { FixedInt_t tmp=*this; tmp|=rhs; return tmp;}
+        FixedInt_t operator^(   const int64    &rhs) & { FixedInt_t tmp=*this; tmp^=rhs; return tmp;}
+
+        FixedInt_t operator>>(  const int      &rhs) & { FixedInt_t tmp=*this; tmp>>=rhs; return tmp;}
+        FixedInt_t operator<<(  const int      &rhs) & { FixedInt_t tmp=*this; tmp<<=rhs; return tmp;}
+
+        // temporaries are worked on in place, see DoubleInt_t
+        FixedInt_t operator+(   const FixedInt_t &rhs) && { AddDouble(this,rhs,0); return std::move(*this);}
+        FixedInt_t operator-(   const FixedInt_t &rhs) && { SubDouble(this,rhs,0); return std::move(*this);}
+        FixedInt_t operator/(   const FixedInt_t &rhs) && { DivideDouble(this,rhs); return std::move(*this);}
+        FixedInt_t operator%(   const FixedInt_t &rhs) && { *this=DivideDouble(this,rhs); return std::move(*this);}
+        FixedInt_t operator*(   const FixedInt_t &rhs) && { MultiplyLow(this,rhs); return std::move(*this);}
+
+        FixedInt_t operator&(   const int64    &rhs) && { Limb[0]&=rhs; return std::move(*this);}
+        FixedInt_t operator|(   const int64    &rhs) && { Limb[0]|=rhs; return std::move(*this);}
+        FixedInt_t operator^(   const int64    &rhs) && { Limb[0]^=rhs; return std::move(*this);}
+
+        FixedInt_t operator>>(  const int      &rhs) && { *this>>=rhs; return std::move(*this);}
+        FixedInt_t operator<<(  const int      &rhs) && { *this<<=rhs; return std::move(*this);}
+
+        // a+b*c and a*(b+c), here the right hand side is the temporary
+        friend FixedInt_t operator+(FixedInt_t &lhs,FixedInt_t &&rhs) { AddDouble(&rhs,lhs,0); return std::move(rhs);}
+        friend FixedInt_t operator*(FixedInt_t &lhs,FixedInt_t &&rhs) { MultiplyLow(&rhs,lhs); return std::move(rhs);}
+
+        // input/output routines
+        string AsString(const char *format);
+        void   FromString(const char *Source_prm);
+        char   GetLowByte() {return Limb[0]&0xFF;}
+//  protected:
+        // these operations are exported for higher level use
+        // they don't use the this variable...
+        static int SubDouble(FixedInt_t *A,const FixedInt_t &B,const int borrow);
+        static int AddDouble(FixedInt_t *A,const FixedInt_t &B,const int carry);
+        static FixedInt_t DivideDouble(FixedInt_t *A,const FixedInt_t &B);
+        static int64 DivideByLimb(FixedInt_t *A,const int64 B,const int64 Remainder=0);
+        static int64 ModByLimb(const FixedInt_t &A,const int64 B,const int64 Remainder=0);
+        static FixedInt_t MultiplyDouble(FixedInt_t *A,const FixedInt_t &B);
+        static FixedInt_t SquareDouble(FixedInt_t *A);
+        static void MultiplyLow(FixedInt_t *A,const FixedInt_t &B);
+        static FixedInt_t AddMulDouble(FixedInt_t *A,const FixedInt_t &B,const FixedInt_t &C);
+        static FixedInt_t SubMulDouble(FixedInt_t *A,const FixedInt_t &B,const FixedInt_t &C);
+        static int64 AddMulLimb(FixedInt_t *A,const FixedInt_t &B,const int64 C) { return ::AddMulLimb(A->Limb,B.Limb,N,C);}
+        static int64 SubMulLimb(FixedInt_t *A,const FixedInt_t &B,const int64 C) { return ::SubMulLimb(A->Limb,B.Limb,N,C);}
+        static int shiftleft(FixedInt_t *Value,const int Carry_prm);
+        static int shiftright(FixedInt_t *Value,const int Carry_prm);
+        static int shiftleftn(FixedInt_t *Value,const int Count) { return ShiftLeftLimbs(Value->Limb,N,Count);}
+        static int shiftrightn(FixedInt_t *Value,const int Count) { return ShiftRightLimbs(Value->Limb,N,Count);}
+        static int Compare(const FixedInt_t &A,const FixedInt_t &B);
+        // flat access to the limbs, least significant limb first
+        static int64 *LimbPtr(FixedInt_t *Value) { return Value->Limb;}
+        static const int64 *LimbPtr(const FixedInt_t &Value) { return Value.Limb;}
+        static void GetLimbs(const FixedInt_t &Value,int64 *Limbs) { for (int x=0;x<N;x++) Limbs[x]=Value.Limb[x];}
+        static void SetLimbs(FixedInt_t *Value,const int64 *Limbs) { for (int x=0;x<N;x++) Value->Limb[x]=Limbs[x];}
+        static constexpr FixedInt_t FromLimbs(const int64 *Limbs) { FixedInt_t ret; for (int x=0;x<N;x++) ret.Limb[x]=Limbs[x]; return ret;}
+//  private:
+        int64 Limb[N];
+        static const int size=N*64;
+        static const int limbs=N;
+        // the doubler nesting level with the same number of limbs (int256=1..),
+        // so DoubleInt_t<FixedInt_t<N> > picks Karatsuba at the same width
+        static const int depth=(N>=64)?5:(N>=32)?4:(N>=16)?3:(N>=8)?2:(N>=4)?1:0;
+};
+
+
+//
+//
+//          The FixedInt_t methods
+//
+//
+//
+
+template<int N> inline int FixedInt_t<N>::AddDouble(FixedInt_t *A,const FixedInt_t &B,const int carry)
+{
+    if (N<=DOUBLEINT_UNROLL_LIMBS)
+    {
+        return AddLimbsUnrolled<N>(A->Limb,B.Limb,carry);
+    }
+    return AddLimbs(A->Limb,B.Limb,N,carry);
+}
+
+template<int N> inline int FixedInt_t<N>::SubDouble(FixedInt_t *A,const FixedInt_t &B,const int borrow)
+{
+    if (N<=DOUBLEINT_UNROLL_LIMBS)
+    {
+        return SubLimbsUnrolled<N>(A->Limb,B.Limb,borrow);
+    }
+    return SubLimbs(A->Limb,B.Limb,N,borrow);
+}
+
+// unsigned compare from the top limb down, -1/0/1
+template<int N> inline int FixedInt_t<N>::Compare(const FixedInt_t &A,const FixedInt_t &B)
+{
+    for (int x=N-1;x>=0;x--)
+    {
+        if (A.Limb[x]!=B.Limb[x])
+        {
+            return ((uint64)A.Limb[x]>(uint64)B.Limb[x])?1:-1;
+        }
+    }
+    return 0;
+}
+
+// low half in A, high half returned. Same as the doubler's MultiplyFlat but
+// the operands don't need to be copied out first.
+template<int N> inline FixedInt_t<N> FixedInt_t<N>::MultiplyDouble(FixedInt_t *A,const FixedInt_t &B)
+{
+    if (A==&B)
+    {
+        return SquareDouble(A);
+    }
+    FixedInt_t ret;
+    LimbBuffer_t<2*N> product;
+    MultiplyLimbs(product,A->Limb,B.Limb,N);
+    SetLimbs(A,product);
+    SetLimbs(&ret,&product[N]);
+    return ret;
+}
+
+template<int N> inline FixedInt_t<N> FixedInt_t<N>::SquareDouble(FixedInt_t *A)
+{
+    FixedInt_t ret;
+    LimbBuffer_t<2*N> product;
+    SquareLimbs(product,A->Limb,N);
+    SetLimbs(A,product);
+    SetLimbs(&ret,&product[N]);
+    return ret;
+}
+
+// (ret:A)=A+B*C, see DoubleInt_t::AddMulDouble
+template<int N> inline FixedInt_t<N> FixedInt_t<N>::AddMulDouble(FixedInt_t *A,const FixedInt_t &B,const FixedInt_t &C)
+{
+    FixedInt_t ret;
+    LimbBuffer_t<2*N> r;
+    AddMulLimbs(r,A->Limb,B.Limb,C.Limb,N);
+    SetLimbs(A,r);
+    SetLimbs(&ret,&r[N]);
+    return ret;
+}
+
+template<int N> inline FixedInt_t<N> FixedInt_t<N>::SubMulDouble(FixedInt_t *A,const FixedInt_t &B,const FixedInt_t &C)
+{
+    FixedInt_t ret;
+    LimbBuffer_t<2*N> r;
+    SubMulLimbs(r,A->Limb,B.Limb,C.Limb,N);
+    SetLimbs(A,r);
+    SetLimbs(&ret,&r[N]);
+    return ret;
+}
+
+// A=A*B keeping only the low N limbs. Row x only needs its low N-x limbs,
+// so this is about half the work of the full product. Toom-3 doesn't
+// truncate, above its threshold the full product is cheaper.
+template<int N> inline void FixedInt_t<N>::MultiplyLow(FixedInt_t *A,const FixedInt_t &B)
+{
+    if (N>=DOUBLEINT_TOOM3_LIMBS)
+    {
+        MultiplyDouble(A,B);
+        return;
+    }
+    LimbBuffer_t<N> r;
+    for (int x=0;x<N;x++)
+    {
+        r[x]=0;
+    }
+    for (int x=0;x<N-1;x++)
+    {
+        // the last limb of each row only needs the low half of its product
+        int64 carry=::AddMulLimb(&r[x],A->Limb,N-x-1,B.Limb[x]);
+        r[N-1]+=carry+(uint64)A->Limb[N-x-1]*(uint64)B.Limb[x];
+    }
+    r[N-1]+=(uint64)A->Limb[0]*(uint64)B.Limb[N-1];
+    SetLimbs(A,r);
+}
+
+// A=(Remainder:A)/B returns the remainder, see int128_t::DivideByLimb
+template<int N> inline int64 FixedInt_t<N>::DivideByLimb(FixedInt_t *A,const int64 B,const int64 Remainder)
+{
+    int64 divisor=B;
+    int64 remainder=Remainder;
+    for (int x=N-1;x>=0;x--)
+    {
+        remainder=Divide64(&A->Limb[x],&remainder,&divisor);
+    }
+    return remainder;
+}
+
+template<int N> inline int64 FixedInt_t<N>::ModByLimb(const FixedInt_t &A,const int64 B,const int64 Remainder)
+{
+    FixedInt_t tmp=A;
+    return DivideByLimb(&tmp,B,Remainder);
+}
+
+// A=A/B Ret=Remainder
+template<int N> FixedInt_t<N> FixedInt_t<N>::DivideDouble(FixedInt_t *A,const FixedInt_t &B)
+{
+    FixedInt_t remainder;
+    LimbBuffer_t<N> q;
+    if (N>=DOUBLEINT_NEWTON_DIVIDE_LIMBS)
+    {
+        DivideLimbsNewton(q,remainder.Limb,A->Limb,B.Limb,N);
+    }
+    else
+    {
+        DivideLimbs(q,remainder.Limb,A->Limb,B.Limb,N);
+    }
+    SetLimbs(A,q);
+    return remainder;
+}
+
+// one bit shifts with a carry in, returns the bit shifted out
+template<int N> inline int FixedInt_t<N>::shiftleft(FixedInt_t *Value,const int Carry_prm)
+{
+    int carry_ret=(uint64)Value->Limb[N-1]>>63;
+    ShiftLeftLimbs(Value->Limb,N,1);
+    Value->Limb[0]|=(Carry_prm!=0);
+    return carry_ret;
+}
+
+template<int N> inline int FixedInt_t<N>::shiftright(FixedInt_t *Value,const int Carry_prm)
+{
+    int carry_ret=Value->Limb[0]&1;
+    ShiftRightLimbs(Value->Limb,N,1);
+    Value->Limb[N-1]|=(int64)(Carry_prm!=0)<<63;
+    return carry_ret;
+}
+
+
+template<int N> string FixedInt_t<N>::AsString(const char *format)
+{
+    string ret;
+    switch (format[1])
+    {
+        case 'd':
+        {
+            // 19 digits at a time, same as the doubler
+            char temp[24];
+            LimbBuffer_t<N> limb;
+            std::vector<int64> chunks;
+            GetLimbs(*this,limb);
+            int used=N;
+            while ((used>0) && (limb[used-1]==0))
+            {
+                used--;
+            }
+            do
+            {
+                chunks.push_back(DivideLimbsByLimb(limb,used,DECIMAL_CHUNK));
+                while ((used>0) && (limb[used-1]==0))
+                {
+                    used--;
+                }
+            } while (used>0);
+
+            sprintf(temp,"%llu",(uint64)chunks.back());
+            ret=temp;
+            for (int x=chunks.size()-2;x>=0;x--)
+            {
+                sprintf(temp,"%019llu",(uint64)chunks[x]);
+                ret+=temp;
+            }
+        }
+        break;
+        case 'b':
+        {
+            for (int x=N*64-1;x>=0;x--)
+            {
+                ret+=((((uint64)Limb[x>>6])>>(x&63))&1)?'1':'0';
+            }
+        }
+        break;
+        case 'X':
+        case 'x':
+        {
+            // full width, a limb at a time
+            char temp[24];
+            for (int x=N-1;x>=0;x--)
+            {
+                sprintf(temp,"%016llX",(uint64)Limb[x]);
+                ret+=temp;
+            }
+        }
+        break;
+    }
+    return ret;
+}
+
+// takes the value as a base 10 or base 16 string, same rules as the doubler
+template<int N> void FixedInt_t<N>::FromString(const char *Source_prm)
+{
+    ParseLimbs(Limb,N,Source_prm);
+}
+
+#endif //FIXEDINT_T_HPP
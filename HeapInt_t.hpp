@@ -0,0 +1,256 @@
+// C++ BigNum template class
+// AKA the integer doubler template.
+// Copyright(C) 2007,2015 Jeremy Linton
+//
+// Source identity: HeapInt_t.hpp
+//
+// Storage for the really big types. A DoubleInt_t is just its limbs, so an
+// int1MB is a megabyte wherever it lives, and a few of those plus the
+// temporaries the operators make will overrun a normal 8MB thread stack.
+//
+// HeapInt_t<> wraps one of the integer classes and keeps the value in a
+// pooled heap buffer instead. Copies still copy, but moves just hand the
+// buffer over, so returning one from an operator is cheap.
+//
+//   typedef class HeapInt_t<int1MB>  hint1MB;
+//   hint1MB a(3),b(5);
+//   hint1MB c=a*b;     // c takes the result's buffer, nothing is copied
+//
+// The product and dividend copies the operations make (LimbBuffer_t) switch
+// from the stack to the same pools once they are DOUBLEINT_HEAP_BITS or wider.
+// The limb kernels' working space comes from ScratchArena_t (int128_t.hpp).
+//
+// See DoubleInt_t.hpp for more information
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+// USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef HEAPINT_T_HPP
+#define HEAPINT_T_HPP
+
+#include <new>
+#include <utility>
+#include "int128_t.hpp"
+
+// Scratch limb arrays this many bits or wider come from the pools rather
+// than the stack
+#ifndef DOUBLEINT_HEAP_BITS
+#define DOUBLEINT_HEAP_BITS 65536
+#endif
+
+// Freed buffers each thread keeps (per size) for reuse
+#ifndef DOUBLEINT_POOL_DEPTH
+#define DOUBLEINT_POOL_DEPTH 8
+#endif
+
+
+// Buffers of Size limbs. Each thread has its own short free list, so there
+// isn't any locking. A buffer can be freed on a different thread than the one
+// that allocated it, it just ends up in that thread's list.
+template<int Size> class LimbPool_t
+{
+    public:
+        static void *Get();
+        static void Put(void *Buffer);
+//  private:
+        struct Cache_t
+        {
+            void *Free[DOUBLEINT_POOL_DEPTH];
+            int   Count;
+        };
+        // hands the cached buffers back when the thread exits, after that
+        // Put frees directly (Count=-1)
+        struct Release_t
+        {
+            ~Release_t();
+        };
+        static Cache_t &Cache();
+};
+
+// the cache is plain data so it is still there for any Put() made after
+// the release runs
+template<int Size> typename LimbPool_t<Size>::Cache_t &LimbPool_t<Size>::Cache()
+{
+    static thread_local Cache_t cache;
+    static thread_local Release_t release;
+    return cache;
+}
+
+template<int Size> LimbPool_t<Size>::Release_t::~Release_t()
+{
+    Cache_t &cache=Cache();
+    while (cache.Count>0)
+    {
+        ::operator delete(cache.Free[--cache.Count]);
+    }
+    cache.Count=-1;
+}
+
+template<int Size> void *LimbPool_t<Size>::Get()
+{
+    Cache_t &cache=Cache();
+    if (cache.Count>0)
+    {
+        return cache.Free[--cache.Count];
+    }
+    return ::operator new(Size*sizeof(int64));
+}
+
+template<int Size> void LimbPool_t<Size>::Put(void *Buffer)
+{
+    Cache_t &cache=Cache();
+    if ((cache.Count>=0) && (cache.Count<DOUBLEINT_POOL_DEPTH))
+    {
+        cache.Free[cache.Count++]=Buffer;
+        return;
+    }
+    ::operator delete(Buffer);
+}
+
+
+// Scratch limbs for the kernels, an ordinary array until it gets wide
+// enough to be a threat to the stack
+template<int Size,bool Heap=(Size*64>=DOUBLEINT_HEAP_BITS)> class LimbBuffer_t
+{
+    public:
+        operator int64 *() { return Limb;}
+        int64 Limb[Size];
+};
+
+template<int Size> class LimbBuffer_t<Size,true>
+{
+    public:
+        LimbBuffer_t():Limb((int64 *)LimbPool_t<Size>::Get()) {}
+        ~LimbBuffer_t() { LimbPool_t<Size>::Put(Limb);}
+        LimbBuffer_t(const LimbBuffer_t &orig)=delete;
+        LimbBuffer_t &operator= (const LimbBuffer_t &rhs)=delete;
+        operator int64 *() { return Limb;}
+        int64 *Limb;
+};
+
+
+// IntT (DoubleInt_t, FixedInt_t..) kept in a pooled buffer. The interface is
+// the same as the wrapped class. A moved from value may only be assigned to
+// or destroyed.
+template<class IntT> class HeapInt_t
+{
+    public:
+        // construction/casting, the wrapped value is built directly in the buffer
+        HeapInt_t()                      :Value(new (Pool::Get()) IntT()) {}
+        HeapInt_t(const HeapInt_t &orig) :Value(new (Pool::Get()) IntT(*orig.Value)) {}
+        HeapInt_t(HeapInt_t &&orig)      :Value(orig.Value) { orig.Value=NULL;}
+        HeapInt_t(const IntT      &orig) :Value(new (Pool::Get()) IntT(orig)) {}
+        HeapInt_t(const int64     &orig) :Value(new (Pool::Get()) IntT(orig)) {}
+        ~HeapInt_t() { if (Value) Pool::Put(Value);}
+        // assignment
+        HeapInt_t &operator= (const HeapInt_t &rhs) { if (Value) *Value=*rhs.Value; else Value=new (Pool::Get()) IntT(*rhs.Value); return *this;}
+        HeapInt_t &operator= (HeapInt_t &&rhs) { std::swap(Value,rhs.Value); return *this;}
+        // compariston
+        bool     operator==(const HeapInt_t &rhs) const { return *Value==*rhs.Value;}
+        bool     operator!=(const HeapInt_t &rhs) const { return *Value!=*rhs.Value;}
+        bool     operator>=(const HeapInt_t &rhs) const { return *Value>=*rhs.Value;}
+        bool     operator<=(const HeapInt_t &rhs) const { return *Value<=*rhs.Value;}
+        bool     operator> (const HeapInt_t &rhs) const { return *Value>*rhs.Value;}
+        bool     operator< (const HeapInt_t &rhs) const { return *Value<*rhs.Value;}
+        // operations (these are exported for user use)
+        HeapInt_t &operator>>=(const int      rhs)  { IntT::shiftrightn(Value,rhs); return *this;}
+        HeapInt_t &operator<<=(const int      rhs)  { IntT::shiftleftn(Value,rhs); return *this;}
+        HeapInt_t &operator-=( const HeapInt_t &rhs) { IntT::SubDouble(Value,*rhs.Value,0); return *this;}
+        HeapInt_t &operator+=( const HeapInt_t &rhs) { IntT::AddDouble(Value,*rhs.Value,0); return *this;}
+        HeapInt_t &operator*=( const HeapInt_t &rhs) { IntT::MultiplyLow(Value,*rhs.Value); return *this;}
+        HeapInt_t &operator/=( const HeapInt_t &rhs) { IntT::DivideDouble(Value,*rhs.Value); return *this;}
+        HeapInt_t &operator%=( const HeapInt_t &rhs) { *this=DivideDouble(this,rhs); return *this;}
+
+        HeapInt_t &operator&=( const int64 &rhs) { *Value&=rhs; return *this;}
+        HeapInt_t &operator|=( const int64 &rhs) { *Value|=rhs; return *this;}
+        HeapInt_t &operator^=( const int64 &rhs) { *Value^=rhs; return *this;}
+
+        HeapInt_t &operator&=( const HeapInt_t &rhs) { *Value&=*rhs.Value; return *this;}
+        HeapInt_t &operator|=( const HeapInt_t &rhs) { *Value|=*rhs.Value; return *this;}
+        HeapInt_t &operator^=( const HeapInt_t &rhs) { *Value^=*rhs.Value; return *this;}
+
+        HeapInt_t operator+(   const HeapInt_t &rhs) const & { HeapInt_t tmp=*this; tmp+=rhs; return tmp;}
+        HeapInt_t operator-(   const HeapInt_t &rhs) const & { HeapInt_t tmp=*this; tmp-=rhs; return tmp;}
+        HeapInt_t operator/(   const HeapInt_t &rhs) const & { HeapInt_t tmp=*this; tmp/=rhs; return tmp;}
+        HeapInt_t operator%(   const HeapInt_t &rhs) const & { HeapInt_t tmp=*this; return DivideDouble(&tmp,rhs);}
+        HeapInt_t operator*(   const HeapInt_t &rhs) const & { HeapInt_t tmp=*this; tmp*=rhs; return tmp;}
+        HeapInt_t Square() const { HeapInt_t tmp=*this; SquareDouble(&tmp); return tmp;}
+
+        HeapInt_t operator&(   const int64    &rhs) const & { HeapInt_t tmp=*this; tmp&=rhs; return tmp;}
+        HeapInt_t operator|(   const int64    &rhs) const & { HeapInt_t tmp=*this; tmp|=rhs; return tmp;}
+        HeapInt_t operator^(   const int64    &rhs) const & { HeapInt_t tmp=*this; tmp^=rhs; return tmp;}
+
+        HeapInt_t operator>>(  const int      &rhs) const & { HeapInt_t tmp=*this; tmp>>=rhs; return tmp;}
+        HeapInt_t operator<<(  const int      &rhs) const & { HeapInt_t tmp=*this; tmp<<=rhs; return tmp;}
+
+        // temporaries are worked on in place and moved along, see DoubleInt_t
+        HeapInt_t operator+(   const HeapInt_t &rhs) && { *this+=rhs; return std::move(*this);}
+        HeapInt_t operator-(   const HeapInt_t &rhs) && { *this-=rhs; return std::move(*this);}
+        HeapInt_t operator/(   const HeapInt_t &rhs) && { *this/=rhs; return std::move(*this);}
+        HeapInt_t operator%(   const HeapInt_t &rhs) && { return DivideDouble(this,rhs);}
+        HeapInt_t operator*(   const HeapInt_t &rhs) && { *this*=rhs; return std::move(*this);}
+
+        HeapInt_t operator&(   const int64    &rhs) && { *this&=rhs; return std::move(*this);}
+        HeapInt_t operator|(   const int64    &rhs) && { *this|=rhs; return std::move(*this);}
+        HeapInt_t operator^(   const int64    &rhs) && { *this^=rhs; return std::move(*this);}
+
+        HeapInt_t operator>>(  const int      &rhs) && { *this>>=rhs; return std::move(*this);}
+        HeapInt_t operator<<(  const int      &rhs) && { *this<<=rhs; return std::move(*this);}
+
+        friend HeapInt_t operator+(HeapInt_t &lhs,HeapInt_t &&rhs) { rhs+=lhs; return std::move(rhs);}
+        friend HeapInt_t operator*(HeapInt_t &lhs,HeapInt_t &&rhs) { rhs*=lhs; return std::move(rhs);}
+
+        // input/output routines
+        string AsString(const char *format) { return Value->AsString(format);}
+        void   FromString(const char *Source_prm) { Value->FromString(Source_prm);}
+        char   GetLowByte() {return Value->GetLowByte();}
+//  protected:
+        // these operations are exported for higher level use
+        // they don't use the this variable... The results are built in
+        // their own pooled buffer rather than passing through the stack,
+        // which is owned by ret first so a throw (divide by zero) returns it.
+        static int SubDouble(HeapInt_t *A,const HeapInt_t &B,const int borrow) { return IntT::SubDouble(A->Value,*B.Value,borrow);}
+        static int AddDouble(HeapInt_t *A,const HeapInt_t &B,const int carry) { return IntT::AddDouble(A->Value,*B.Value,carry);}
+        static HeapInt_t DivideDouble(HeapInt_t *A,const HeapInt_t &B) { HeapInt_t ret(static_cast<IntT *>(Pool::Get()),Adopt_t()); new (ret.Value) IntT(IntT::DivideDouble(A->Value,*B.Value)); return ret;}
+        static int64 DivideByLimb(HeapInt_t *A,const int64 B,const int64 Remainder=0) { return IntT::DivideByLimb(A->Value,B,Remainder);}
+        static int64 ModByLimb(const HeapInt_t &A,const int64 B,const int64 Remainder=0) { return IntT::ModByLimb(*A.Value,B,Remainder);}
+        static HeapInt_t MultiplyDouble(HeapInt_t *A,const HeapInt_t &B) { HeapInt_t ret(static_cast<IntT *>(Pool::Get()),Adopt_t()); new (ret.Value) IntT(IntT::MultiplyDouble(A->Value,*B.Value)); return ret;}
+        static HeapInt_t SquareDouble(HeapInt_t *A) { HeapInt_t ret(static_cast<IntT *>(Pool::Get()),Adopt_t()); new (ret.Value) IntT(IntT::SquareDouble(A->Value)); return ret;}
+        static void MultiplyLow(HeapInt_t *A,const HeapInt_t &B) { IntT::MultiplyLow(A->Value,*B.Value);}
+        static HeapInt_t AddMulDouble(HeapInt_t *A,const HeapInt_t &B,const HeapInt_t &C) { HeapInt_t ret(static_cast<IntT *>(Pool::Get()),Adopt_t()); new (ret.Value) IntT(IntT::AddMulDouble(A->Value,*B.Value,*C.Value)); return ret;}
+        static HeapInt_t SubMulDouble(HeapInt_t *A,const HeapInt_t &B,const HeapInt_t &C) { HeapInt_t ret(static_cast<IntT *>(Pool::Get()),Adopt_t()); new (ret.Value) IntT(IntT::SubMulDouble(A->Value,*B.Value,*C.Value)); return ret;}
+        static int64 AddMulLimb(HeapInt_t *A,const HeapInt_t &B,const int64 C) { return IntT::AddMulLimb(A->Value,*B.Value,C);}
+        static int64 SubMulLimb(HeapInt_t *A,const HeapInt_t &B,const int64 C) { return IntT::SubMulLimb(A->Value,*B.Value,C);}
+        static int shiftleft(HeapInt_t *Value,const int Carry_prm) { return IntT::shiftleft(Value->Value,Carry_prm);}
+        static int shiftright(HeapInt_t *Value,const int Carry_prm) { return IntT::shiftright(Value->Value,Carry_prm);}
+        static int shiftleftn(HeapInt_t *Value,const int Count) { return IntT::shiftleftn(Value->Value,Count);}
+        static int shiftrightn(HeapInt_t *Value,const int Count) { return IntT::shiftrightn(Value->Value,Count);}
+        // flat access to the limbs, least significant limb first
+        static void GetLimbs(const HeapInt_t &Value,int64 *Limbs) { IntT::GetLimbs(*Value.Value,Limbs);}
+        static void SetLimbs(HeapInt_t *Value,const int64 *Limbs) { IntT::SetLimbs(Value->Value,Limbs);}
+//  private:
+        typedef LimbPool_t<(sizeof(IntT)+sizeof(int64)-1)/sizeof(int64)> Pool;
+        // takes over a pool buffer that already holds a value
+        struct Adopt_t {};
+        HeapInt_t(IntT *Buffer,Adopt_t) :Value(Buffer) {}
+        IntT *Value;
+        static const int size=IntT::size;
+        static const int limbs=IntT::limbs;
+        static const int depth=IntT::depth;
+};
+
+#endif //HEAPINT_T_HPP
@@ -0,0 +1,319 @@
+// C++ BigNum template class
+// AKA the integer doubler template.
+// Copyright(C) 2007,2015 Jeremy Linton
+//
+// Source identity: Montgomery.hpp
+//
+// Modular multiply and exponentiation for a fixed odd modulus without any
+// division. Values are kept in Montgomery form (x*R mod m, R=2^(64*limbs))
+// where a multiply is followed by a REDC step that only needs multiplies and
+// adds by the modulus. The context precomputes R^2 mod m (to get into
+// Montgomery form) and -m^-1 mod 2^64 (for the REDC steps).
+//
+//   typedef class DoubleInt_t<int1024>   int2048;
+//   MontgomeryContext_t<int2048> ctx(modulus);
+//   int2048 sig=ctx.ModPow(message,exponent);
+//
+// See DoubleInt_t.hpp for more information
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+// USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef MONTGOMERY_HPP
+#define MONTGOMERY_HPP
+
+#include <vector>
+#include "DoubleInt_t.hpp"
+
+
+// -M^-1 mod 2^64 for odd M, Newton's method doubles the correct bits each
+// step and M itself is already right to 3 bits
+static inline int64 MontgomeryInverse64(const int64 M)
+{
+    uint64 m=M;
+    uint64 inv=m;
+    for (int x=0;x<5;x++)
+    {
+        inv*=2-m*inv;
+    }
+    return -(int64)inv;
+}
+
+// R=A*B*2^(-64*Size) mod M, CIOS (coarsely integrated operand scanning).
+// Each row adds A*B[x] and then a multiple of M which zeros the bottom limb,
+// rather than shifting the accumulator down a limb the window just slides up
+// the scratch buffer T (2*Size+2 limbs). A and B must be less than M.
+static inline void MontgomeryMultiplyLimbs(int64 *R,const int64 *A,const int64 *B,const int64 *M,const int64 MInv,const int Size,int64 *T)
+{
+    for (int x=0;x<2*Size+2;x++)
+    {
+        T[x]=0;
+    }
+    int64 zero=0;
+    for (int x=0;x<Size;x++)
+    {
+        int64 *t=&T[x];
+        int64 carry=AddMulLimb(t,A,Size,B[x]);
+        int c=Add64(&t[Size],&carry,0);
+        Add64(&t[Size+1],&zero,c);
+        int64 m=(uint64)t[0]*(uint64)MInv;
+        carry=AddMulLimb(t,M,Size,m);
+        c=Add64(&t[Size],&carry,0);
+        Add64(&t[Size+1],&zero,c);
+    }
+    // t<2M, one subtract at most
+    int64 *t=&T[Size];
+    if ((t[Size]!=0) || GreaterEqualLimbs(t,M,Size))
+    {
+        SubLimbs(t,M,Size,0);
+    }
+    for (int x=0;x<Size;x++)
+    {
+        R[x]=t[x];
+    }
+}
+
+// R=T*2^(-64*Size) mod M where T is 2*Size limbs (and less than M*2^(64*Size)).
+// T is used as scratch.
+static inline void MontgomeryReduceLimbs(int64 *R,int64 *T,const int64 *M,const int64 MInv,const int Size)
+{
+    int64 top=0;
+    int64 zero=0;
+    for (int x=0;x<Size;x++)
+    {
+        int64 m=(uint64)T[x]*(uint64)MInv;
+        int64 carry=AddMulLimb(&T[x],M,Size,m);
+        int c=Add64(&T[x+Size],&carry,0);
+        for (int y=x+Size+1;(y<2*Size) && c;y++)
+        {
+            c=Add64(&T[y],&zero,c);
+        }
+        top+=c;
+    }
+    if ((top!=0) || GreaterEqualLimbs(&T[Size],M,Size))
+    {
+        SubLimbs(&T[Size],M,Size,0);
+    }
+    for (int x=0;x<Size;x++)
+    {
+        R[x]=T[Size+x];
+    }
+}
+
+// R=A*A*2^(-64*Size) mod M, the square kernel does about half the multiplies
+// of the CIOS loop and the REDC pass costs the same either way. T is scratch
+// of 2*Size+2 limbs like the multiply.
+static inline void MontgomerySquareLimbs(int64 *R,const int64 *A,const int64 *M,const int64 MInv,const int Size,int64 *T)
+{
+    SquareLimbs(T,A,Size);
+    MontgomeryReduceLimbs(R,T,M,MInv,Size);
+}
+
+
+// The modulus must be odd (otherwise there isn't an inverse mod 2^64) and the
+// values passed to Multiply/Square must be in Montgomery form and less than
+// the modulus. ModPow takes and returns ordinary values.
+template<class IntT> class MontgomeryContext_t
+{
+    public:
+        MontgomeryContext_t(const IntT &Modulus);
+
+        IntT ToMontgomery(const IntT &A);
+        IntT FromMontgomery(const IntT &A);
+        IntT Multiply(const IntT &A,const IntT &B);
+        IntT Square(const IntT &A);
+        IntT ModPow(const IntT &Base,const IntT &Exponent);
+//  private:
+        static const int limbs=IntT::limbs;
+        int64 modulus[limbs];
+        int64 r2[limbs];      // R^2 mod m
+        int64 one[limbs];     // R mod m, aka 1 in Montgomery form
+        int64 minv;           // -m^-1 mod 2^64
+};
+
+
+template<class IntT> MontgomeryContext_t<IntT>::MontgomeryContext_t(const IntT &Modulus)
+{
+    IntT::GetLimbs(Modulus,modulus);
+    if ((modulus[0]&1)==0)
+    {
+        throw "Montgomery modulus must be odd";
+    }
+    minv=MontgomeryInverse64(modulus[0]);
+
+    // R mod m, then keep doubling mod m to get R^2 mod m
+    IntT m=Modulus;
+    IntT r=IntT(0);
+    IntT::SubDouble(&r,m,0); // 2^N-m
+    IntT rmodm=IntT::DivideDouble(&r,m);
+    IntT::GetLimbs(rmodm,one);
+    for (int x=0;x<limbs;x++)
+    {
+        r2[x]=one[x];
+    }
+    for (int x=0;x<limbs*64;x++)
+    {
+        int carry=ShiftLeftLimbs(r2,limbs,1);
+        if (carry || GreaterEqualLimbs(r2,modulus,limbs))
+        {
+            SubLimbs(r2,modulus,limbs,0);
+        }
+    }
+}
+
+template<class IntT> IntT MontgomeryContext_t<IntT>::ToMontgomery(const IntT &A)
+{
+    IntT ret;
+    int64 a[limbs],r[limbs],t[2*limbs+2];
+    IntT::GetLimbs(A,a);
+    MontgomeryMultiplyLimbs(r,a,r2,modulus,minv,limbs,t);
+    IntT::SetLimbs(&ret,r);
+    return ret;
+}
+
+template<class IntT> IntT MontgomeryContext_t<IntT>::FromMontgomery(const IntT &A)
+{
+    IntT ret;
+    int64 t[limbs*2],r[limbs];
+    IntT::GetLimbs(A,t);
+    for (int x=limbs;x<limbs*2;x++)
+    {
+        t[x]=0;
+    }
+    MontgomeryReduceLimbs(r,t,modulus,minv,limbs);
+    IntT::SetLimbs(&ret,r);
+    return ret;
+}
+
+template<class IntT> IntT MontgomeryContext_t<IntT>::Multiply(const IntT &A,const IntT &B)
+{
+    IntT ret;
+    int64 a[limbs],b[limbs],r[limbs],t[2*limbs+2];
+    IntT::GetLimbs(A,a);
+    IntT::GetLimbs(B,b);
+    MontgomeryMultiplyLimbs(r,a,b,modulus,minv,limbs,t);
+    IntT::SetLimbs(&ret,r);
+    return ret;
+}
+
+template<class IntT> IntT MontgomeryContext_t<IntT>::Square(const IntT &A)
+{
+    IntT ret;
+    int64 a[limbs],r[limbs],t[2*limbs+2];
+    IntT::GetLimbs(A,a);
+    MontgomerySquareLimbs(r,a,modulus,minv,limbs,t);
+    IntT::SetLimbs(&ret,r);
+    return ret;
+}
+
+// Base^Exponent mod m, left to right sliding window. The table holds the odd
+// powers Base^1,Base^3...Base^(2^window-1) so each window of the exponent
+// costs one multiply and runs of zero bits only cost squares.
+template<class IntT> IntT MontgomeryContext_t<IntT>::ModPow(const IntT &Base,const IntT &Exponent)
+{
+    IntT ret;
+    int64 e[limbs];
+    IntT::GetLimbs(Exponent,e);
+    int topbit=limbs*64-1;
+    while ((topbit>=0) && ((((uint64)e[topbit>>6])>>(topbit&63))&1)==0)
+    {
+        topbit--;
+    }
+    int window=(topbit>671)?6:(topbit>239)?5:(topbit>79)?4:(topbit>23)?3:(topbit>7)?2:1;
+
+    // reduce the base (it may be bigger than m) and build the table
+    IntT base=Base;
+    IntT m;
+    IntT::SetLimbs(&m,modulus);
+    IntT reduced=IntT::DivideDouble(&base,m);
+    std::vector<int64> table((1<<(window-1))*limbs);
+    int64 b2[limbs],acc[limbs],tmp[limbs],t[2*limbs+2];
+    IntT::GetLimbs(ToMontgomery(reduced),&table[0]);
+    MontgomerySquareLimbs(b2,&table[0],modulus,minv,limbs,t);
+    for (int x=1;x<(1<<(window-1));x++)
+    {
+        MontgomeryMultiplyLimbs(&table[x*limbs],&table[(x-1)*limbs],b2,modulus,minv,limbs,t);
+    }
+
+    for (int x=0;x<limbs;x++)
+    {
+        acc[x]=one[x];
+    }
+    bool started=false;
+    int bit=topbit;
+    while (bit>=0)
+    {
+        if (((((uint64)e[bit>>6])>>(bit&63))&1)==0)
+        {
+            if (started)
+            {
+                MontgomerySquareLimbs(tmp,acc,modulus,minv,limbs,t);
+                for (int x=0;x<limbs;x++)
+                {
+                    acc[x]=tmp[x];
+                }
+            }
+            bit--;
+            continue;
+        }
+        // longest window starting here that ends on a one bit
+        int low=bit-window+1;
+        if (low<0)
+        {
+            low=0;
+        }
+        while (((((uint64)e[low>>6])>>(low&63))&1)==0)
+        {
+            low++;
+        }
+        int value=0;
+        for (int x=bit;x>=low;x--)
+        {
+            value=(value<<1)|((((uint64)e[x>>6])>>(x&63))&1);
+        }
+        if (started)
+        {
+            for (int x=bit;x>=low;x--)
+            {
+                MontgomerySquareLimbs(tmp,acc,modulus,minv,limbs,t);
+                for (int y=0;y<limbs;y++)
+                {
+                    acc[y]=tmp[y];
+                }
+            }
+            MontgomeryMultiplyLimbs(tmp,acc,&table[(value>>1)*limbs],modulus,minv,limbs,t);
+            for (int x=0;x<limbs;x++)
+            {
+                acc[x]=tmp[x];
+            }
+        }
+        else
+        {
+            for (int x=0;x<limbs;x++)
+            {
+                acc[x]=table[(value>>1)*limbs+x];
+            }
+            started=true;
+        }
+        bit=low-1;
+    }
+
+    IntT::SetLimbs(&ret,acc);
+    return FromMontgomery(ret);
+}
+
+#endif //MONTGOMERY_HPP
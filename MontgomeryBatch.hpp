@@ -0,0 +1,377 @@
+// C++ BigNum template class
+// AKA the integer doubler template.
+// Copyright(C) 2007,2015 Jeremy Linton
+//
+// Source identity: MontgomeryBatch.hpp
+//
+// Eight modular multiplies (or exponentiations) at once for a shared odd
+// modulus, aimed at checking a pile of signatures against one key:
+//
+//   MontgomeryBatch_t<int2048> batch(m);
+//   batch.Multiply(r,a,b,n);          // r[x]=a[x]*b[x] mod m
+//   batch.ModPow(r,s,e,n);            // r[x]=s[x]^e mod m
+//
+// AVX-512 IFMA (vpmadd52luq/vpmadd52huq) multiplies 52 bit numbers and adds
+// the low or high 52 bits of the product to a 64 bit lane. So the values
+// are converted to radix 2^52 and laid out digit by digit, eight values
+// side by side (Digits[digit*8+lane]). Each instruction then works on the
+// same digit of eight different multiplies. The 12 spare bits a lane leave
+// room for the column sums, so carries are only sorted out once at the end.
+// The Montgomery multiply is the same CIOS as MontgomeryMultiplyLimbs, but
+// with R=2^(52*digits).
+//
+// Without IFMA (or with DOUBLEINT_NO_IFMA) the same radix 2^52 steps run a
+// lane at a time on plain 64 bit multiplies, so the results can be checked
+// anywhere. Either way the results are fully reduced.
+//
+// See DoubleInt_t.hpp for more information
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+// USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef MONTGOMERYBATCH_HPP
+#define MONTGOMERYBATCH_HPP
+
+#include "Montgomery.hpp"
+#include "BatchInt.hpp"
+
+static inline bool CpuHasIfma()
+{
+#ifdef DOUBLEINT_NO_IFMA
+    return false;
+#else
+    return DoubleIntHaveAvx512 && CpuHasSimd(21,0xe6);
+#endif
+}
+
+static const bool DoubleIntHaveIfma=CpuHasIfma();
+
+static const uint64 Digit52Mask=(1ULL<<52)-1;
+
+// Limbs (64 bit) to radix 2^52 digits for one lane of the interleaved layout
+static inline void LimbsToDigits52(uint64 *Digits,const int DigitCount,const int Lane,const int64 *Limbs,const int LimbCount)
+{
+    for (int x=0;x<DigitCount;x++)
+    {
+        int bit=x*52;
+        int limb=bit>>6;
+        int shift=bit&63;
+        uint64 value=0;
+        if (limb<LimbCount)
+        {
+            value=((uint64)Limbs[limb])>>shift;
+            if ((shift>12) && (limb+1<LimbCount))
+            {
+                value|=((uint64)Limbs[limb+1])<<(64-shift);
+            }
+        }
+        Digits[x*8+Lane]=value&Digit52Mask;
+    }
+}
+
+// and back, the value has to fit in LimbCount limbs
+static inline void Digits52ToLimbs(int64 *Limbs,const int LimbCount,const uint64 *Digits,const int DigitCount,const int Lane)
+{
+    for (int x=0;x<LimbCount;x++)
+    {
+        Limbs[x]=0;
+    }
+    for (int x=0;x<DigitCount;x++)
+    {
+        uint64 value=Digits[x*8+Lane];
+        int bit=x*52;
+        int limb=bit>>6;
+        int shift=bit&63;
+        if (limb<LimbCount)
+        {
+            Limbs[limb]|=(int64)(value<<shift);
+            if ((shift>12) && (limb+1<LimbCount))
+            {
+                Limbs[limb+1]|=(int64)(value>>(64-shift));
+            }
+        }
+    }
+}
+
+// what vpmadd52luq/vpmadd52huq do to one lane
+static inline uint64 MultiplyAdd52Lo(const uint64 Acc,const uint64 A,const uint64 B)
+{
+    return Acc+((uint64)((unsigned __int128)(A&Digit52Mask)*(B&Digit52Mask))&Digit52Mask);
+}
+
+static inline uint64 MultiplyAdd52Hi(const uint64 Acc,const uint64 A,const uint64 B)
+{
+    return Acc+(uint64)(((unsigned __int128)(A&Digit52Mask)*(B&Digit52Mask))>>52);
+}
+
+// R=A*B/2^(52*Digits) mod M for the eight lanes, a lane at a time. A, B and R
+// are interleaved, M is the shared modulus one digit per entry and K0 is
+// -M^-1 mod 2^52. A and B must be less than M.
+template<int Digits> static inline void MontgomeryMultiply52(uint64 *R,const uint64 *A,const uint64 *B,const uint64 *M,const uint64 K0)
+{
+    for (int lane=0;lane<8;lane++)
+    {
+        uint64 acc[Digits+1];
+        for (int x=0;x<=Digits;x++)
+        {
+            acc[x]=0;
+        }
+        for (int x=0;x<Digits;x++)
+        {
+            uint64 b=B[x*8+lane];
+            for (int y=0;y<Digits;y++)
+            {
+                acc[y]=MultiplyAdd52Lo(acc[y],A[y*8+lane],b);
+                acc[y+1]=MultiplyAdd52Hi(acc[y+1],A[y*8+lane],b);
+            }
+            uint64 m=MultiplyAdd52Lo(0,acc[0],K0);
+            for (int y=0;y<Digits;y++)
+            {
+                acc[y]=MultiplyAdd52Lo(acc[y],M[y],m);
+                acc[y+1]=MultiplyAdd52Hi(acc[y+1],M[y],m);
+            }
+            // the bottom digit is zero now, slide the window down
+            acc[1]+=acc[0]>>52;
+            for (int y=0;y<Digits;y++)
+            {
+                acc[y]=acc[y+1];
+            }
+            acc[Digits]=0;
+        }
+        // carries, then one subtract at most since acc<2M
+        for (int x=0;x<Digits-1;x++)
+        {
+            acc[x+1]+=acc[x]>>52;
+            acc[x]&=Digit52Mask;
+        }
+        uint64 diff[Digits];
+        uint64 borrow=0;
+        for (int x=0;x<Digits;x++)
+        {
+            uint64 d=acc[x]-M[x]-borrow;
+            borrow=d>>63;
+            diff[x]=(x<Digits-1)?(d&Digit52Mask):d;
+        }
+        for (int x=0;x<Digits;x++)
+        {
+            R[x*8+lane]=borrow?acc[x]:diff[x];
+        }
+    }
+}
+
+// the same with all eight lanes in one register per digit
+template<int Digits> __attribute__((target("avx512f,avx512ifma"))) static inline void MontgomeryMultiply52Ifma(uint64 *R,const uint64 *A,const uint64 *B,const uint64 *M,const uint64 K0)
+{
+    __m512i acc[Digits+1];
+    const __m512i zero=_mm512_setzero_si512();
+    const __m512i mask=_mm512_set1_epi64(Digit52Mask);
+    const __m512i k0=_mm512_set1_epi64(K0);
+    for (int x=0;x<=Digits;x++)
+    {
+        acc[x]=zero;
+    }
+    for (int x=0;x<Digits;x++)
+    {
+        __m512i b=_mm512_loadu_si512(&B[x*8]);
+        for (int y=0;y<Digits;y++)
+        {
+            __m512i a=_mm512_loadu_si512(&A[y*8]);
+            acc[y]=_mm512_madd52lo_epu64(acc[y],a,b);
+            acc[y+1]=_mm512_madd52hi_epu64(acc[y+1],a,b);
+        }
+        __m512i m=_mm512_madd52lo_epu64(zero,acc[0],k0);
+        for (int y=0;y<Digits;y++)
+        {
+            __m512i mod=_mm512_set1_epi64(M[y]);
+            acc[y]=_mm512_madd52lo_epu64(acc[y],mod,m);
+            acc[y+1]=_mm512_madd52hi_epu64(acc[y+1],mod,m);
+        }
+        acc[1]=_mm512_add_epi64(acc[1],_mm512_maskz_srli_epi64((__mmask8)0xFF,acc[0],52));
+        for (int y=0;y<Digits;y++)
+        {
+            acc[y]=acc[y+1];
+        }
+        acc[Digits]=zero;
+    }
+    for (int x=0;x<Digits-1;x++)
+    {
+        acc[x+1]=_mm512_add_epi64(acc[x+1],_mm512_maskz_srli_epi64((__mmask8)0xFF,acc[x],52));
+        acc[x]=_mm512_and_si512(acc[x],mask);
+    }
+    __m512i diff[Digits];
+    __m512i borrow=zero;
+    for (int x=0;x<Digits;x++)
+    {
+        __m512i d=_mm512_sub_epi64(_mm512_sub_epi64(acc[x],_mm512_set1_epi64(M[x])),borrow);
+        borrow=_mm512_maskz_srli_epi64((__mmask8)0xFF,d,63);
+        diff[x]=(x<Digits-1)?_mm512_and_si512(d,mask):d;
+    }
+    __mmask8 keep=_mm512_test_epi64_mask(borrow,borrow);
+    for (int x=0;x<Digits;x++)
+    {
+        _mm512_storeu_si512(&R[x*8],_mm512_mask_blend_epi64(keep,diff[x],acc[x]));
+    }
+}
+
+
+// The modulus must be odd, and the values passed in less than it. Up to
+// eight values are worked on at once, N can be anything.
+template<class IntT> class MontgomeryBatch_t
+{
+    public:
+        MontgomeryBatch_t(const IntT &Modulus);
+
+        void Multiply(IntT *R,const IntT *A,const IntT *B,const size_t N);
+        void ModPow(IntT *R,const IntT *Base,const IntT &Exponent,const size_t N);
+//  private:
+        static const int limbs=IntT::limbs;
+        static const int digits=(limbs*64+51)/52;
+        void MultiplyDigits(uint64 *R,const uint64 *A,const uint64 *B);
+        void ToDigits(uint64 *Digits,const IntT *Values,const size_t N);
+        void FromDigits(IntT *Values,const uint64 *Digits,const size_t N);
+
+        uint64 modulus[digits];
+        uint64 r2[digits*8];     // R^2 mod m in every lane, R=2^(52*digits)
+        uint64 one[digits*8];    // 1 in every lane
+        uint64 k0;               // -m^-1 mod 2^52
+        bool   ifma;             // use the IFMA kernel, otherwise the lane at a time one
+};
+
+
+template<class IntT> MontgomeryBatch_t<IntT>::MontgomeryBatch_t(const IntT &Modulus)
+{
+    int64 m[limbs];
+    IntT::GetLimbs(Modulus,m);
+    if ((m[0]&1)==0)
+    {
+        throw "Montgomery modulus must be odd";
+    }
+    k0=((uint64)MontgomeryInverse64(m[0]))&Digit52Mask;
+    ifma=DoubleIntHaveIfma;
+
+    // 2^(2*52*digits) mod m, by doubling 1 that many times
+    int64 r[limbs];
+    for (int x=0;x<limbs;x++)
+    {
+        r[x]=(x==0);
+    }
+    for (int x=0;x<2*52*digits;x++)
+    {
+        int carry=ShiftLeftLimbs(r,limbs,1);
+        if (carry || GreaterEqualLimbs(r,m,limbs))
+        {
+            SubLimbs(r,m,limbs,0);
+        }
+    }
+    uint64 digit[digits*8];
+    LimbsToDigits52(digit,digits,0,m,limbs);
+    for (int x=0;x<digits;x++)
+    {
+        modulus[x]=digit[x*8];
+    }
+    for (int lane=0;lane<8;lane++)
+    {
+        LimbsToDigits52(r2,digits,lane,r,limbs);
+        for (int x=0;x<digits;x++)
+        {
+            one[x*8+lane]=(x==0);
+        }
+    }
+}
+
+template<class IntT> void MontgomeryBatch_t<IntT>::MultiplyDigits(uint64 *R,const uint64 *A,const uint64 *B)
+{
+    if (ifma)
+    {
+        MontgomeryMultiply52Ifma<digits>(R,A,B,modulus,k0);
+    }
+    else
+    {
+        MontgomeryMultiply52<digits>(R,A,B,modulus,k0);
+    }
+}
+
+// the lanes past N are zero, which stays zero
+template<class IntT> void MontgomeryBatch_t<IntT>::ToDigits(uint64 *Digits,const IntT *Values,const size_t N)
+{
+    int64 zero[limbs]={0};
+    for (int lane=0;lane<8;lane++)
+    {
+        LimbsToDigits52(Digits,digits,lane,((size_t)lane<N)?IntT::LimbPtr(Values[lane]):zero,limbs);
+    }
+}
+
+template<class IntT> void MontgomeryBatch_t<IntT>::FromDigits(IntT *Values,const uint64 *Digits,const size_t N)
+{
+    for (size_t lane=0;(lane<8) && (lane<N);lane++)
+    {
+        Digits52ToLimbs(IntT::LimbPtr(&Values[lane]),limbs,Digits,digits,lane);
+    }
+}
+
+// A*B/R then times R^2/R puts the R back, so no conversions are needed
+template<class IntT> void MontgomeryBatch_t<IntT>::Multiply(IntT *R,const IntT *A,const IntT *B,const size_t N)
+{
+    uint64 a[digits*8],b[digits*8],t[digits*8];
+    for (size_t x=0;x<N;x+=8)
+    {
+        ToDigits(a,&A[x],N-x);
+        ToDigits(b,&B[x],N-x);
+        MultiplyDigits(t,a,b);
+        MultiplyDigits(a,t,r2);
+        FromDigits(&R[x],a,N-x);
+    }
+}
+
+// Base[x]^Exponent mod m, left to right square and multiply. The exponent
+// is shared so all eight lanes take the same steps.
+template<class IntT> void MontgomeryBatch_t<IntT>::ModPow(IntT *R,const IntT *Base,const IntT &Exponent,const size_t N)
+{
+    int64 e[limbs];
+    IntT::GetLimbs(Exponent,e);
+    int topbit=limbs*64-1;
+    while ((topbit>=0) && ((((uint64)e[topbit>>6])>>(topbit&63))&1)==0)
+    {
+        topbit--;
+    }
+    uint64 base[digits*8],acc[digits*8],tmp[digits*8];
+    for (size_t x=0;x<N;x+=8)
+    {
+        ToDigits(tmp,&Base[x],N-x);
+        MultiplyDigits(base,tmp,r2);  // into Montgomery form
+        MultiplyDigits(acc,one,r2);   // R mod m, 1 in Montgomery form
+        for (int bit=topbit;bit>=0;bit--)
+        {
+            MultiplyDigits(tmp,acc,acc);
+            if ((((uint64)e[bit>>6])>>(bit&63))&1)
+            {
+                MultiplyDigits(acc,tmp,base);
+            }
+            else
+            {
+                for (int y=0;y<digits*8;y++)
+                {
+                    acc[y]=tmp[y];
+                }
+            }
+        }
+        MultiplyDigits(tmp,acc,one);  // and back out
+        FromDigits(&R[x],tmp,N-x);
+    }
+}
+
+#endif //MONTGOMERYBATCH_HPP
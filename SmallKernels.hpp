@@ -0,0 +1,1105 @@
+// C++ BigNum template class
+// AKA the integer doubler template.
+// Copyright(C) 2007,2015 Jeremy Linton
+//
+// Source identity: SmallKernels.hpp
+//
+// Straight line kernels for the two widths that get used the most, 4 limbs
+// (int256) and 8 limbs (int512). The nested DoubleInt_t<int128> and
+// DoubleInt_t<int256> build every multiply out of int128 pieces and copy the
+// halves around between them, at these sizes that overhead is most of the
+// cost. These are fully unrolled, with no loop counters or half width
+// temporaries, DoubleInt_t.hpp specializes the int256 and int512
+// add/sub/equal/multiply/square members onto them. The ordering compares
+// stay generic, they mostly settle on the top limb with a predictable branch
+// and a borrow chain through every limb was slower.
+//
+// The multiplies and squares use mulx/adcx/adox (see DoubleIntHaveAdx), a row
+// per limb with the low halves on one carry chain and the high halves on the
+// other. Without ADX they fall back to the basecase limb loops.
+//
+// See DoubleInt_t.hpp for more information
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+// USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef SMALLKERNELS_HPP
+#define SMALLKERNELS_HPP
+
+#include "int128_t.hpp"
+
+// A+=B over exactly four limbs, returns the carry
+static inline int AddLimbs4(int64 *A,const int64 *B,const int carry)
+{
+    int64 carry_io=carry;
+    int64 tmp;
+    asm volatile ("add $-1, %[carry]       \n\t"
+         "mov (%[a]), %[tmp]      \n\t"
+         "adc (%[b]), %[tmp]      \n\t"
+         "mov %[tmp], (%[a])      \n\t"
+         "mov 8(%[a]), %[tmp]     \n\t"
+         "adc 8(%[b]), %[tmp]     \n\t"
+         "mov %[tmp], 8(%[a])     \n\t"
+         "mov 16(%[a]), %[tmp]    \n\t"
+         "adc 16(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 16(%[a])    \n\t"
+         "mov 24(%[a]), %[tmp]    \n\t"
+         "adc 24(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 24(%[a])    \n\t"
+         "sbb %[carry], %[carry]  \n\t"
+         : [carry] "+&r" (carry_io), [tmp] "=&r" (tmp)
+         : [a] "r" (A), [b] "r" (B)
+         : "cc", "memory"
+        );
+    return (int)-carry_io;
+}
+
+// A-=B over exactly four limbs, returns the borrow
+static inline int SubLimbs4(int64 *A,const int64 *B,const int borrow)
+{
+    int64 carry_io=borrow;
+    int64 tmp;
+    asm volatile ("add $-1, %[carry]       \n\t"
+         "mov (%[a]), %[tmp]      \n\t"
+         "sbb (%[b]), %[tmp]      \n\t"
+         "mov %[tmp], (%[a])      \n\t"
+         "mov 8(%[a]), %[tmp]     \n\t"
+         "sbb 8(%[b]), %[tmp]     \n\t"
+         "mov %[tmp], 8(%[a])     \n\t"
+         "mov 16(%[a]), %[tmp]    \n\t"
+         "sbb 16(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 16(%[a])    \n\t"
+         "mov 24(%[a]), %[tmp]    \n\t"
+         "sbb 24(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 24(%[a])    \n\t"
+         "sbb %[carry], %[carry]  \n\t"
+         : [carry] "+&r" (carry_io), [tmp] "=&r" (tmp)
+         : [a] "r" (A), [b] "r" (B)
+         : "cc", "memory"
+        );
+    return (int)-carry_io;
+}
+
+// the same for eight limbs
+static inline int AddLimbs8(int64 *A,const int64 *B,const int carry)
+{
+    int64 carry_io=carry;
+    int64 tmp;
+    asm volatile ("add $-1, %[carry]       \n\t"
+         "mov (%[a]), %[tmp]      \n\t"
+         "adc (%[b]), %[tmp]      \n\t"
+         "mov %[tmp], (%[a])      \n\t"
+         "mov 8(%[a]), %[tmp]     \n\t"
+         "adc 8(%[b]), %[tmp]     \n\t"
+         "mov %[tmp], 8(%[a])     \n\t"
+         "mov 16(%[a]), %[tmp]    \n\t"
+         "adc 16(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 16(%[a])    \n\t"
+         "mov 24(%[a]), %[tmp]    \n\t"
+         "adc 24(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 24(%[a])    \n\t"
+         "mov 32(%[a]), %[tmp]    \n\t"
+         "adc 32(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 32(%[a])    \n\t"
+         "mov 40(%[a]), %[tmp]    \n\t"
+         "adc 40(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 40(%[a])    \n\t"
+         "mov 48(%[a]), %[tmp]    \n\t"
+         "adc 48(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 48(%[a])    \n\t"
+         "mov 56(%[a]), %[tmp]    \n\t"
+         "adc 56(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 56(%[a])    \n\t"
+         "sbb %[carry], %[carry]  \n\t"
+         : [carry] "+&r" (carry_io), [tmp] "=&r" (tmp)
+         : [a] "r" (A), [b] "r" (B)
+         : "cc", "memory"
+        );
+    return (int)-carry_io;
+}
+
+static inline int SubLimbs8(int64 *A,const int64 *B,const int borrow)
+{
+    int64 carry_io=borrow;
+    int64 tmp;
+    asm volatile ("add $-1, %[carry]       \n\t"
+         "mov (%[a]), %[tmp]      \n\t"
+         "sbb (%[b]), %[tmp]      \n\t"
+         "mov %[tmp], (%[a])      \n\t"
+         "mov 8(%[a]), %[tmp]     \n\t"
+         "sbb 8(%[b]), %[tmp]     \n\t"
+         "mov %[tmp], 8(%[a])     \n\t"
+         "mov 16(%[a]), %[tmp]    \n\t"
+         "sbb 16(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 16(%[a])    \n\t"
+         "mov 24(%[a]), %[tmp]    \n\t"
+         "sbb 24(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 24(%[a])    \n\t"
+         "mov 32(%[a]), %[tmp]    \n\t"
+         "sbb 32(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 32(%[a])    \n\t"
+         "mov 40(%[a]), %[tmp]    \n\t"
+         "sbb 40(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 40(%[a])    \n\t"
+         "mov 48(%[a]), %[tmp]    \n\t"
+         "sbb 48(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 48(%[a])    \n\t"
+         "mov 56(%[a]), %[tmp]    \n\t"
+         "sbb 56(%[b]), %[tmp]    \n\t"
+         "mov %[tmp], 56(%[a])    \n\t"
+         "sbb %[carry], %[carry]  \n\t"
+         : [carry] "+&r" (carry_io), [tmp] "=&r" (tmp)
+         : [a] "r" (A), [b] "r" (B)
+         : "cc", "memory"
+        );
+    return (int)-carry_io;
+}
+
+// R[0..8)=A*B, one mulx row per limb of B. The four running columns stay
+// in registers, the low halves of a row go down the OF chain and the high
+// halves down the CF chain, each finished column is stored as it drops out.
+static inline void MultiplyLimbs4Adx(int64 *R,const int64 *A,const int64 *B)
+{
+    int64 s0,s1,s2,s3,s4,lo,hi,z;
+    asm volatile ("xor %k[z], %k[z]             \n\t"
+         "mov (%[b]), %%rdx            \n\t"
+         "mulx (%[a]), %[s0], %[s1]    \n\t"
+         "mulx 8(%[a]), %[lo], %[s2]   \n\t"
+         "adcx %[lo], %[s1]            \n\t"
+         "mulx 16(%[a]), %[lo], %[s3]  \n\t"
+         "adcx %[lo], %[s2]            \n\t"
+         "mulx 24(%[a]), %[lo], %[s4]  \n\t"
+         "adcx %[lo], %[s3]            \n\t"
+         "adcx %[z], %[s4]             \n\t"
+         "mov %[s0], (%[r])            \n\t"
+         "mov 8(%[b]), %%rdx           \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox %[lo], %[s1]            \n\t"
+         "adcx %[hi], %[s2]            \n\t"
+         "mulx 8(%[a]), %[lo], %[hi]   \n\t"
+         "adox %[lo], %[s2]            \n\t"
+         "adcx %[hi], %[s3]            \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adox %[lo], %[s3]            \n\t"
+         "adcx %[hi], %[s4]            \n\t"
+         "mulx 24(%[a]), %[lo], %[s0]  \n\t"
+         "adox %[lo], %[s4]            \n\t"
+         "adcx %[z], %[s0]             \n\t"
+         "adox %[z], %[s0]             \n\t"
+         "mov %[s1], 8(%[r])           \n\t"
+         "mov 16(%[b]), %%rdx          \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox %[lo], %[s2]            \n\t"
+         "adcx %[hi], %[s3]            \n\t"
+         "mulx 8(%[a]), %[lo], %[hi]   \n\t"
+         "adox %[lo], %[s3]            \n\t"
+         "adcx %[hi], %[s4]            \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adox %[lo], %[s4]            \n\t"
+         "adcx %[hi], %[s0]            \n\t"
+         "mulx 24(%[a]), %[lo], %[s1]  \n\t"
+         "adox %[lo], %[s0]            \n\t"
+         "adcx %[z], %[s1]             \n\t"
+         "adox %[z], %[s1]             \n\t"
+         "mov %[s2], 16(%[r])          \n\t"
+         "mov 24(%[b]), %%rdx          \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox %[lo], %[s3]            \n\t"
+         "adcx %[hi], %[s4]            \n\t"
+         "mulx 8(%[a]), %[lo], %[hi]   \n\t"
+         "adox %[lo], %[s4]            \n\t"
+         "adcx %[hi], %[s0]            \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adox %[lo], %[s0]            \n\t"
+         "adcx %[hi], %[s1]            \n\t"
+         "mulx 24(%[a]), %[lo], %[s2]  \n\t"
+         "adox %[lo], %[s1]            \n\t"
+         "adcx %[z], %[s2]             \n\t"
+         "adox %[z], %[s2]             \n\t"
+         "mov %[s3], 24(%[r])          \n\t"
+         "mov %[s4], 32(%[r])          \n\t"
+         "mov %[s0], 40(%[r])          \n\t"
+         "mov %[s1], 48(%[r])          \n\t"
+         "mov %[s2], 56(%[r])          \n\t"
+         : [s0] "=&r" (s0), [s1] "=&r" (s1), [s2] "=&r" (s2), [s3] "=&r" (s3), [s4] "=&r" (s4), [lo] "=&r" (lo), [hi] "=&r" (hi), [z] "=&r" (z)
+         : [a] "r" (A), [b] "r" (B), [r] "r" (R)
+         : "rdx", "cc", "memory"
+        );
+}
+
+// R[0..8)=A*A. The six cross products are summed in registers, then doubled
+// down the OF chain while the squares of each limb go in down the CF chain.
+static inline void SquareLimbs4Adx(int64 *R,const int64 *A)
+{
+    int64 t1,t2,t3,t4,t5,t6,lo,hi,z;
+    asm volatile ("xor %k[z], %k[z]             \n\t"
+         "mov (%[a]), %%rdx            \n\t"
+         "mulx 8(%[a]), %[t1], %[t2]   \n\t"
+         "mulx 16(%[a]), %[lo], %[t3]  \n\t"
+         "adcx %[lo], %[t2]            \n\t"
+         "mulx 24(%[a]), %[lo], %[t4]  \n\t"
+         "adcx %[lo], %[t3]            \n\t"
+         "adcx %[z], %[t4]             \n\t"
+         "mov 8(%[a]), %%rdx           \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adox %[lo], %[t3]            \n\t"
+         "adcx %[hi], %[t4]            \n\t"
+         "mulx 24(%[a]), %[lo], %[t5]  \n\t"
+         "adox %[lo], %[t4]            \n\t"
+         "adcx %[z], %[t5]             \n\t"
+         "adox %[z], %[t5]             \n\t"
+         "mov 16(%[a]), %%rdx          \n\t"
+         "mulx 24(%[a]), %[lo], %[t6]  \n\t"
+         "adcx %[lo], %[t5]            \n\t"
+         "adcx %[z], %[t6]             \n\t"
+         "mov (%[a]), %%rdx            \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "mov %[lo], (%[r])            \n\t"
+         "adox %[t1], %[t1]            \n\t"
+         "adcx %[hi], %[t1]            \n\t"
+         "mov %[t1], 8(%[r])           \n\t"
+         "mov 8(%[a]), %%rdx           \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "adox %[t2], %[t2]            \n\t"
+         "adcx %[lo], %[t2]            \n\t"
+         "mov %[t2], 16(%[r])          \n\t"
+         "adox %[t3], %[t3]            \n\t"
+         "adcx %[hi], %[t3]            \n\t"
+         "mov %[t3], 24(%[r])          \n\t"
+         "mov 16(%[a]), %%rdx          \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "adox %[t4], %[t4]            \n\t"
+         "adcx %[lo], %[t4]            \n\t"
+         "mov %[t4], 32(%[r])          \n\t"
+         "adox %[t5], %[t5]            \n\t"
+         "adcx %[hi], %[t5]            \n\t"
+         "mov %[t5], 40(%[r])          \n\t"
+         "mov 24(%[a]), %%rdx          \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "adox %[t6], %[t6]            \n\t"
+         "adcx %[lo], %[t6]            \n\t"
+         "mov %[t6], 48(%[r])          \n\t"
+         "adox %[z], %[hi]             \n\t"
+         "adcx %[z], %[hi]             \n\t"
+         "mov %[hi], 56(%[r])          \n\t"
+         : [t1] "=&r" (t1), [t2] "=&r" (t2), [t3] "=&r" (t3), [t4] "=&r" (t4), [t5] "=&r" (t5), [t6] "=&r" (t6), [lo] "=&r" (lo), [hi] "=&r" (hi), [z] "=&r" (z)
+         : [a] "r" (A), [r] "r" (R)
+         : "rdx", "cc", "memory"
+        );
+}
+
+// R[0..4)=A*B truncated, the rows stop at the fourth column and the product
+// that lands in it is only an imul. imul trashes the flags so each row does
+// it first and then clears them.
+static inline void MultiplyLowLimbs4Adx(int64 *R,const int64 *A,const int64 *B)
+{
+    int64 s0,s1,s2,s3,lo,hi,t;
+    asm volatile ("mov (%[b]), %%rdx            \n\t"
+         "mov 24(%[a]), %[s3]          \n\t"
+         "imul %%rdx, %[s3]            \n\t"
+         "xor %k[lo], %k[lo]           \n\t"
+         "mulx (%[a]), %[s0], %[s1]    \n\t"
+         "mulx 8(%[a]), %[lo], %[s2]   \n\t"
+         "adcx %[lo], %[s1]            \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[lo], %[s2]            \n\t"
+         "adcx %[hi], %[s3]            \n\t"
+         "mov 8(%[b]), %%rdx           \n\t"
+         "mov 16(%[a]), %[t]           \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "xor %k[lo], %k[lo]           \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox %[lo], %[s1]            \n\t"
+         "adcx %[hi], %[s2]            \n\t"
+         "mulx 8(%[a]), %[lo], %[hi]   \n\t"
+         "adox %[lo], %[s2]            \n\t"
+         "adcx %[hi], %[s3]            \n\t"
+         "adox %[t], %[s3]             \n\t"
+         "mov 16(%[b]), %%rdx          \n\t"
+         "mov 8(%[a]), %[t]            \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "xor %k[lo], %k[lo]           \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox %[lo], %[s2]            \n\t"
+         "adcx %[hi], %[s3]            \n\t"
+         "adox %[t], %[s3]             \n\t"
+         "mov 24(%[b]), %[t]           \n\t"
+         "imul (%[a]), %[t]            \n\t"
+         "add %[t], %[s3]              \n\t"
+         "mov %[s0], (%[r])            \n\t"
+         "mov %[s1], 8(%[r])           \n\t"
+         "mov %[s2], 16(%[r])          \n\t"
+         "mov %[s3], 24(%[r])          \n\t"
+         : [s0] "=&r" (s0), [s1] "=&r" (s1), [s2] "=&r" (s2), [s3] "=&r" (s3), [lo] "=&r" (lo), [hi] "=&r" (hi), [t] "=&r" (t)
+         : [a] "r" (A), [b] "r" (B), [r] "r" (R)
+         : "rdx", "cc", "memory"
+        );
+}
+
+// R[0..16)=A*B, the same two chain rows as AddMulLimbAdx without the loop.
+// Eight running columns don't fit in the registers, so they are kept in R.
+static inline void MultiplyLimbs8Adx(int64 *R,const int64 *A,const int64 *B)
+{
+    int64 lo,hi,c,z;
+    asm volatile ("xor %k[z], %k[z]             \n\t"
+         "mov (%[b]), %%rdx            \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "mov %[lo], (%[r])            \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 8(%[r])           \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], 16(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "mov %[c], 64(%[r])           \n\t"
+         "mov 8(%[b]), %%rdx           \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox 8(%[r]), %[lo]          \n\t"
+         "mov %[lo], 8(%[r])           \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 16(%[r]), %[lo]         \n\t"
+         "mov %[lo], 16(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 24(%[r]), %[lo]         \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 32(%[r]), %[lo]         \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 72(%[r])           \n\t"
+         "mov 16(%[b]), %%rdx          \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox 16(%[r]), %[lo]         \n\t"
+         "mov %[lo], 16(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 24(%[r]), %[lo]         \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 32(%[r]), %[lo]         \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 72(%[r]), %[lo]         \n\t"
+         "mov %[lo], 72(%[r])          \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 80(%[r])           \n\t"
+         "mov 24(%[b]), %%rdx          \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox 24(%[r]), %[lo]         \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 32(%[r]), %[lo]         \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 72(%[r]), %[lo]         \n\t"
+         "mov %[lo], 72(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 80(%[r]), %[lo]         \n\t"
+         "mov %[lo], 80(%[r])          \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 88(%[r])           \n\t"
+         "mov 32(%[b]), %%rdx          \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox 32(%[r]), %[lo]         \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 72(%[r]), %[lo]         \n\t"
+         "mov %[lo], 72(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 80(%[r]), %[lo]         \n\t"
+         "mov %[lo], 80(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 88(%[r]), %[lo]         \n\t"
+         "mov %[lo], 88(%[r])          \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 96(%[r])           \n\t"
+         "mov 40(%[b]), %%rdx          \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 72(%[r]), %[lo]         \n\t"
+         "mov %[lo], 72(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 80(%[r]), %[lo]         \n\t"
+         "mov %[lo], 80(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 88(%[r]), %[lo]         \n\t"
+         "mov %[lo], 88(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 96(%[r]), %[lo]         \n\t"
+         "mov %[lo], 96(%[r])          \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 104(%[r])          \n\t"
+         "mov 48(%[b]), %%rdx          \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 72(%[r]), %[lo]         \n\t"
+         "mov %[lo], 72(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 80(%[r]), %[lo]         \n\t"
+         "mov %[lo], 80(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 88(%[r]), %[lo]         \n\t"
+         "mov %[lo], 88(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 96(%[r]), %[lo]         \n\t"
+         "mov %[lo], 96(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 104(%[r]), %[lo]        \n\t"
+         "mov %[lo], 104(%[r])         \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 112(%[r])          \n\t"
+         "mov 56(%[b]), %%rdx          \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 72(%[r]), %[lo]         \n\t"
+         "mov %[lo], 72(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 80(%[r]), %[lo]         \n\t"
+         "mov %[lo], 80(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 88(%[r]), %[lo]         \n\t"
+         "mov %[lo], 88(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 96(%[r]), %[lo]         \n\t"
+         "mov %[lo], 96(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 104(%[r]), %[lo]        \n\t"
+         "mov %[lo], 104(%[r])         \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 112(%[r]), %[lo]        \n\t"
+         "mov %[lo], 112(%[r])         \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 120(%[r])          \n\t"
+         : [lo] "=&r" (lo), [hi] "=&r" (hi), [c] "=&r" (c), [z] "=&r" (z)
+         : [a] "r" (A), [b] "r" (B), [r] "r" (R)
+         : "rdx", "cc", "memory"
+        );
+}
+
+// R[0..16)=A*A, the cross product triangle goes into R a row at a time, then
+// one pass doubles it (OF chain) and adds the squares of the limbs (CF chain).
+static inline void SquareLimbs8Adx(int64 *R,const int64 *A)
+{
+    int64 lo,hi,c,z;
+    asm volatile ("xor %k[z], %k[z]             \n\t"
+         "mov %[z], (%[r])             \n\t"
+         "mov %[z], 120(%[r])          \n\t"
+         "mov (%[a]), %%rdx            \n\t"
+         "mulx 8(%[a]), %[lo], %[hi]   \n\t"
+         "mov %[lo], 8(%[r])           \n\t"
+         "mulx 16(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 16(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "adcx %[z], %[hi]             \n\t"
+         "mov %[hi], 64(%[r])          \n\t"
+         "mov 8(%[a]), %%rdx           \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adox 24(%[r]), %[lo]         \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 32(%[r]), %[lo]         \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 72(%[r])           \n\t"
+         "mov 16(%[a]), %%rdx          \n\t"
+         "mulx 24(%[a]), %[lo], %[hi]  \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 72(%[r]), %[lo]         \n\t"
+         "mov %[lo], 72(%[r])          \n\t"
+         "adcx %[z], %[hi]             \n\t"
+         "adox %[z], %[hi]             \n\t"
+         "mov %[hi], 80(%[r])          \n\t"
+         "mov 24(%[a]), %%rdx          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adox 56(%[r]), %[lo]         \n\t"
+         "mov %[lo], 56(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 64(%[r]), %[lo]         \n\t"
+         "mov %[lo], 64(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 72(%[r]), %[lo]         \n\t"
+         "mov %[lo], 72(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 80(%[r]), %[lo]         \n\t"
+         "mov %[lo], 80(%[r])          \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 88(%[r])           \n\t"
+         "mov 32(%[a]), %%rdx          \n\t"
+         "mulx 40(%[a]), %[lo], %[hi]  \n\t"
+         "adox 72(%[r]), %[lo]         \n\t"
+         "mov %[lo], 72(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 80(%[r]), %[lo]         \n\t"
+         "mov %[lo], 80(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 88(%[r]), %[lo]         \n\t"
+         "mov %[lo], 88(%[r])          \n\t"
+         "adcx %[z], %[hi]             \n\t"
+         "adox %[z], %[hi]             \n\t"
+         "mov %[hi], 96(%[r])          \n\t"
+         "mov 40(%[a]), %%rdx          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adox 88(%[r]), %[lo]         \n\t"
+         "mov %[lo], 88(%[r])          \n\t"
+         "mulx 56(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 96(%[r]), %[lo]         \n\t"
+         "mov %[lo], 96(%[r])          \n\t"
+         "adcx %[z], %[c]              \n\t"
+         "adox %[z], %[c]              \n\t"
+         "mov %[c], 104(%[r])          \n\t"
+         "mov 48(%[a]), %%rdx          \n\t"
+         "mulx 56(%[a]), %[lo], %[hi]  \n\t"
+         "adox 104(%[r]), %[lo]        \n\t"
+         "mov %[lo], 104(%[r])         \n\t"
+         "adcx %[z], %[hi]             \n\t"
+         "adox %[z], %[hi]             \n\t"
+         "mov %[hi], 112(%[r])         \n\t"
+         "mov (%[a]), %%rdx            \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "mov (%[r]), %[c]             \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[lo], %[c]             \n\t"
+         "mov %[c], (%[r])             \n\t"
+         "mov 8(%[r]), %[c]            \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[hi], %[c]             \n\t"
+         "mov %[c], 8(%[r])            \n\t"
+         "mov 8(%[a]), %%rdx           \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "mov 16(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[lo], %[c]             \n\t"
+         "mov %[c], 16(%[r])           \n\t"
+         "mov 24(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[hi], %[c]             \n\t"
+         "mov %[c], 24(%[r])           \n\t"
+         "mov 16(%[a]), %%rdx          \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "mov 32(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[lo], %[c]             \n\t"
+         "mov %[c], 32(%[r])           \n\t"
+         "mov 40(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[hi], %[c]             \n\t"
+         "mov %[c], 40(%[r])           \n\t"
+         "mov 24(%[a]), %%rdx          \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "mov 48(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[lo], %[c]             \n\t"
+         "mov %[c], 48(%[r])           \n\t"
+         "mov 56(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[hi], %[c]             \n\t"
+         "mov %[c], 56(%[r])           \n\t"
+         "mov 32(%[a]), %%rdx          \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "mov 64(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[lo], %[c]             \n\t"
+         "mov %[c], 64(%[r])           \n\t"
+         "mov 72(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[hi], %[c]             \n\t"
+         "mov %[c], 72(%[r])           \n\t"
+         "mov 40(%[a]), %%rdx          \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "mov 80(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[lo], %[c]             \n\t"
+         "mov %[c], 80(%[r])           \n\t"
+         "mov 88(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[hi], %[c]             \n\t"
+         "mov %[c], 88(%[r])           \n\t"
+         "mov 48(%[a]), %%rdx          \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "mov 96(%[r]), %[c]           \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[lo], %[c]             \n\t"
+         "mov %[c], 96(%[r])           \n\t"
+         "mov 104(%[r]), %[c]          \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[hi], %[c]             \n\t"
+         "mov %[c], 104(%[r])          \n\t"
+         "mov 56(%[a]), %%rdx          \n\t"
+         "mulx %%rdx, %[lo], %[hi]     \n\t"
+         "mov 112(%[r]), %[c]          \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[lo], %[c]             \n\t"
+         "mov %[c], 112(%[r])          \n\t"
+         "mov 120(%[r]), %[c]          \n\t"
+         "adox %[c], %[c]              \n\t"
+         "adcx %[hi], %[c]             \n\t"
+         "mov %[c], 120(%[r])          \n\t"
+         : [lo] "=&r" (lo), [hi] "=&r" (hi), [c] "=&r" (c), [z] "=&r" (z)
+         : [a] "r" (A), [r] "r" (R)
+         : "rdx", "cc", "memory"
+        );
+}
+
+// R[0..8)=A*B truncated, rows as MultiplyLimbs8Adx but each stops at the top
+// limb, whose product is an imul done before the flags are needed.
+static inline void MultiplyLowLimbs8Adx(int64 *R,const int64 *A,const int64 *B)
+{
+    int64 lo,hi,c,t;
+    asm volatile ("mov (%[b]), %%rdx            \n\t"
+         "mov 56(%[a]), %[t]           \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "xor %k[c], %k[c]             \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], (%[r])            \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 8(%[r])           \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], 16(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 48(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "adcx %[hi], %[t]             \n\t"
+         "mov %[t], 56(%[r])           \n\t"
+         "mov 8(%[b]), %%rdx           \n\t"
+         "mov 48(%[a]), %[t]           \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "xor %k[c], %k[c]             \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 8(%[r]), %[lo]          \n\t"
+         "mov %[lo], 8(%[r])           \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 16(%[r]), %[lo]         \n\t"
+         "mov %[lo], 16(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 24(%[r]), %[lo]         \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 32(%[r]), %[lo]         \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 40(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "adcx %[c], %[t]              \n\t"
+         "adox 56(%[r]), %[t]          \n\t"
+         "mov %[t], 56(%[r])           \n\t"
+         "mov 16(%[b]), %%rdx          \n\t"
+         "mov 40(%[a]), %[t]           \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "xor %k[c], %k[c]             \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 16(%[r]), %[lo]         \n\t"
+         "mov %[lo], 16(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 24(%[r]), %[lo]         \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 32(%[r]), %[lo]         \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 32(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "adcx %[hi], %[t]             \n\t"
+         "adox 56(%[r]), %[t]          \n\t"
+         "mov %[t], 56(%[r])           \n\t"
+         "mov 24(%[b]), %%rdx          \n\t"
+         "mov 32(%[a]), %[t]           \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "xor %k[c], %k[c]             \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 24(%[r]), %[lo]         \n\t"
+         "mov %[lo], 24(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 32(%[r]), %[lo]         \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 24(%[a]), %[lo], %[c]   \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "adcx %[c], %[t]              \n\t"
+         "adox 56(%[r]), %[t]          \n\t"
+         "mov %[t], 56(%[r])           \n\t"
+         "mov 32(%[b]), %%rdx          \n\t"
+         "mov 24(%[a]), %[t]           \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "xor %k[c], %k[c]             \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 32(%[r]), %[lo]         \n\t"
+         "mov %[lo], 32(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 16(%[a]), %[lo], %[hi]  \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "adcx %[hi], %[t]             \n\t"
+         "adox 56(%[r]), %[t]          \n\t"
+         "mov %[t], 56(%[r])           \n\t"
+         "mov 40(%[b]), %%rdx          \n\t"
+         "mov 16(%[a]), %[t]           \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "xor %k[c], %k[c]             \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 40(%[r]), %[lo]         \n\t"
+         "mov %[lo], 40(%[r])          \n\t"
+         "mulx 8(%[a]), %[lo], %[c]    \n\t"
+         "adcx %[hi], %[lo]            \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "adcx %[c], %[t]              \n\t"
+         "adox 56(%[r]), %[t]          \n\t"
+         "mov %[t], 56(%[r])           \n\t"
+         "mov 48(%[b]), %%rdx          \n\t"
+         "mov 8(%[a]), %[t]            \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "xor %k[c], %k[c]             \n\t"
+         "mulx (%[a]), %[lo], %[hi]    \n\t"
+         "adcx %[c], %[lo]             \n\t"
+         "adox 48(%[r]), %[lo]         \n\t"
+         "mov %[lo], 48(%[r])          \n\t"
+         "adcx %[hi], %[t]             \n\t"
+         "adox 56(%[r]), %[t]          \n\t"
+         "mov %[t], 56(%[r])           \n\t"
+         "mov 56(%[b]), %%rdx          \n\t"
+         "mov (%[a]), %[t]             \n\t"
+         "imul %%rdx, %[t]             \n\t"
+         "add %[t], 56(%[r])           \n\t"
+         : [lo] "=&r" (lo), [hi] "=&r" (hi), [c] "=&r" (c), [t] "=&r" (t)
+         : [a] "r" (A), [b] "r" (B), [r] "r" (R)
+         : "rdx", "cc", "memory"
+        );
+}
+
+// A==B, no branches until the end
+template<int Size> static inline bool EqualLimbsN(const int64 *A,const int64 *B)
+{
+    int64 diff=0;
+    for (int x=0;x<Size;x++)
+    {
+        diff|=A[x]^B[x];
+    }
+    return diff==0;
+}
+
+// the entry points, with the basecase loops when the CPU doesn't have ADX
+static inline void MultiplyLimbs4(int64 *R,const int64 *A,const int64 *B)
+{
+    if (DoubleIntHaveAdx)
+    {
+        MultiplyLimbs4Adx(R,A,B);
+        return;
+    }
+    MultiplyLimbsBasecase(R,A,4,B,4);
+}
+
+static inline void SquareLimbs4(int64 *R,const int64 *A)
+{
+    if (DoubleIntHaveAdx)
+    {
+        SquareLimbs4Adx(R,A);
+        return;
+    }
+    SquareLimbsBasecase(R,A,4);
+}
+
+static inline void MultiplyLowLimbs4(int64 *R,const int64 *A,const int64 *B)
+{
+    if (DoubleIntHaveAdx)
+    {
+        MultiplyLowLimbs4Adx(R,A,B);
+        return;
+    }
+    int64 product[8];
+    MultiplyLimbsBasecase(product,A,4,B,4);
+    for (int x=0;x<4;x++)
+    {
+        R[x]=product[x];
+    }
+}
+
+static inline void MultiplyLimbs8(int64 *R,const int64 *A,const int64 *B)
+{
+    if (DoubleIntHaveAdx)
+    {
+        MultiplyLimbs8Adx(R,A,B);
+        return;
+    }
+    MultiplyLimbsBasecase(R,A,8,B,8);
+}
+
+static inline void SquareLimbs8(int64 *R,const int64 *A)
+{
+    if (DoubleIntHaveAdx)
+    {
+        SquareLimbs8Adx(R,A);
+        return;
+    }
+    SquareLimbsBasecase(R,A,8);
+}
+
+static inline void MultiplyLowLimbs8(int64 *R,const int64 *A,const int64 *B)
+{
+    if (DoubleIntHaveAdx)
+    {
+        MultiplyLowLimbs8Adx(R,A,B);
+        return;
+    }
+    int64 product[16];
+    MultiplyLimbsBasecase(product,A,8,B,8);
+    for (int x=0;x<8;x++)
+    {
+        R[x]=product[x];
+    }
+}
+
+#endif // SMALLKERNELS_HPP
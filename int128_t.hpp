@@ -34,11 +34,17 @@
 
 #include <stdio.h>
 #include <string>
+#include <vector>
 #include <sys/time.h>
 using std::string;
 
-typedef long long int64;
-typedef int       int32;
+typedef long long          int64;
+typedef unsigned long long uint64;
+typedef int                int32;
+
+// largest power of 10 that fits in a limb, the decimal conversions work in
+// 19 digit chunks of this
+static const int64 DECIMAL_CHUNK=10000000000000000000ULL;
 
 // This class is the base class for the Doubler, it provides the
 // helper routines like         
@@ -54,24 +60,25 @@ typedef class int128_t
 {
     public:
         // construction/casting
-        int128_t()                    :Hi(0),Lo(0) {}
-        int128_t(const int128_t &orig):Hi(orig.Hi),Lo(orig.Lo) {}
-        int128_t(const int64    &orig):Hi(0),Lo(orig) {}
+        constexpr int128_t()                    :Lo(0),Hi(0) {}
+        int128_t(const int128_t &orig)=default;
+        constexpr int128_t(const int64    &orig):Lo(orig),Hi(0) {}
         // assignment
-        int128_t &operator= (const int128_t &rhs) {Hi=rhs.Hi;Lo=rhs.Lo;return *this;}
+        int128_t &operator= (const int128_t &rhs)=default;
         // compariston
         bool     operator==(const int128_t &rhs) { if ((Hi==rhs.Hi) && (Lo==rhs.Lo)) return true; return false;}
         bool     operator!=(const int128_t &rhs) { if ((Hi==rhs.Hi) && (Lo==rhs.Lo)) return false; return true;}
-        bool     operator>=(const int128_t &rhs) { if ((Hi>rhs.Hi) || ( (Hi==rhs.Hi) && (Lo>=rhs.Lo))) return true; return false;}
-        bool     operator<=(const int128_t &rhs) { if ((Hi<rhs.Hi) || ( (Hi==rhs.Hi) && (Lo<=rhs.Lo))) return true; return false;}
-        bool     operator> (const int128_t &rhs) { if ((Hi>rhs.Hi) || ( (Hi==rhs.Hi) && (Lo>rhs.Lo ))) return true; return false;}
-        bool     operator< (const int128_t &rhs) { if ((Hi<rhs.Hi) || ( (Hi==rhs.Hi) && (Lo<rhs.Lo ))) return true; return false;}
+        // the value is unsigned, so compare the limbs as unsigned
+        bool     operator>=(const int128_t &rhs) { if (((uint64)Hi>(uint64)rhs.Hi) || ( (Hi==rhs.Hi) && ((uint64)Lo>=(uint64)rhs.Lo))) return true; return false;}
+        bool     operator<=(const int128_t &rhs) { if (((uint64)Hi<(uint64)rhs.Hi) || ( (Hi==rhs.Hi) && ((uint64)Lo<=(uint64)rhs.Lo))) return true; return false;}
+        bool     operator> (const int128_t &rhs) { if (((uint64)Hi>(uint64)rhs.Hi) || ( (Hi==rhs.Hi) && ((uint64)Lo>(uint64)rhs.Lo ))) return true; return false;}
+        bool     operator< (const int128_t &rhs) { if (((uint64)Hi<(uint64)rhs.Hi) || ( (Hi==rhs.Hi) && ((uint64)Lo<(uint64)rhs.Lo ))) return true; return false;}
         // operations (these are exported for user use)
-        int128_t &operator>>=(const int      rhs)  { for (int x=0;x<rhs;x++) shiftright(this,0); return *this;}
-        int128_t &operator<<=(const int      rhs)  { for (int x=0;x<rhs;x++) shiftleft(this,0); return *this;}
+        int128_t &operator>>=(const int      rhs)  { shiftrightn(this,rhs); return *this;}
+        int128_t &operator<<=(const int      rhs)  { shiftleftn(this,rhs); return *this;}
         int128_t &operator-=( const int128_t &rhs) { SubDouble(this,rhs,0); return *this;}
         int128_t &operator+=( const int128_t &rhs) { AddDouble(this,rhs,0); return *this;}
-        int128_t &operator*=( const int128_t &rhs) { MultiplyDouble(this,rhs); return *this;}
+        int128_t &operator*=( const int128_t &rhs) { MultiplyLow(this,rhs); return *this;}
         int128_t &operator/=( const int128_t &rhs) { DivideDouble(this,rhs); return *this;}
         int128_t &operator%=( const int128_t &rhs) { *this=DivideDouble(this,rhs); return *this;}
 
@@ -89,7 +96,8 @@ typedef class int128_t
         int128_t operator-(   const int128_t &rhs) { int128_t tmp=*this; SubDouble(&tmp,rhs,0); return tmp;}
         int128_t operator/(   const int128_t &rhs) { int128_t tmp=*this; DivideDouble(&tmp,rhs); return tmp;}
         int128_t operator%(   const int128_t &rhs) { int128_t tmp=*this; tmp=DivideDouble(&tmp,rhs); return tmp;}
-        int128_t operator*(   const int128_t &rhs) { int128_t tmp=*this; MultiplyDouble(&tmp,rhs); return tmp;}
+        int128_t operator*(   const int128_t &rhs) { int128_t tmp=*this; MultiplyLow(&tmp,rhs); return tmp;}
+        int128_t Square() { int128_t tmp=*this; SquareDouble(&tmp); return tmp;}
 
         int128_t operator&(   const int64    &rhs) { int128_t tmp=*this; tmp&=rhs; return tmp;}
         int128_t operator|(   const int64    &rhs) { int128_t tmp=*this; tmp|=rhs; return tmp;}
@@ -107,15 +115,36 @@ typedef class int128_t
         static int SubDouble(int128_t *A,const int128_t &B,const int borrow);       
         static int AddDouble(int128_t *A,const int128_t &B,const int carry);
         static int128_t DivideDouble(int128_t *A,const int128_t &B);
+        static int64 DivideByLimb(int128_t *A,const int64 B,const int64 Remainder=0);
+        static int64 ModByLimb(const int128_t &A,const int64 B,const int64 Remainder=0);
         static int128_t MultiplyDouble(int128_t *A,const int128_t &B);
+        static int128_t SquareDouble(int128_t *A);
+        static int128_t MultiplyDoubleAdx(int128_t *A,const int128_t &B);
+        static int128_t SquareDoubleAdx(int128_t *A);
+        static void MultiplyLow(int128_t *A,const int128_t &B);
+        static int128_t AddMulDouble(int128_t *A,const int128_t &B,const int128_t &C);
+        static int128_t SubMulDouble(int128_t *A,const int128_t &B,const int128_t &C);
+        static int64 AddMulLimb(int128_t *A,const int128_t &B,const int64 C);
+        static int64 SubMulLimb(int128_t *A,const int128_t &B,const int64 C);
         static int shiftleft(int128_t *Value,const int Carry_prm);
         static int shiftright(int128_t *Value,const int Carry_prm);
+        static int shiftleftn(int128_t *Value,const int Count);
+        static int shiftrightn(int128_t *Value,const int Count);
+        // flat access to the limbs, least significant limb first (which is
+        // also how they're laid out, see DoubleInt_t::LimbPtr)
+        static int64 *LimbPtr(int128_t *Value) { return &Value->Lo;}
+        static const int64 *LimbPtr(const int128_t &Value) { return &Value.Lo;}
+        static void GetLimbs(const int128_t &Value,int64 *Limbs) { Limbs[0]=Value.Lo; Limbs[1]=Value.Hi;}
+        static void SetLimbs(int128_t *Value,const int64 *Limbs) { Value->Lo=Limbs[0]; Value->Hi=Limbs[1];}
+        // SetLimbs that can run at compile time, see ConstFromString
+        static constexpr int128_t FromLimbs(const int64 *Limbs) { int128_t ret; ret.Lo=Limbs[0]; ret.Hi=Limbs[1]; return ret;}
 //  private:
-        int64 Hi;
         int64 Lo;
-        static const int size; //clean up the memory allocation slightly by moving this out of band..
+        int64 Hi;
+        static const int size=128; //clean up the memory allocation slightly by moving this out of band..
+        static const int limbs=2;
+        static const int depth=0; //nesting level, the doublers count up from here
 } int128;
-const int int128::size=128;
 
 /*bool operator==(const int128 &a,const int128 &b)
 {
@@ -146,8 +175,7 @@ static inline int64 Multiply64(int64 *A, int64 *B)
 }
 
 // take a long word B:A and divide by C, result in A and remainder is returned
-// This is provided for completeness but isn't used because the 
-// divide double is implemented as shifts/subtracts like the doubler is
+// B must be smaller than C or the quotient won't fit in 64-bits
 static inline int64 Divide64(int64 *A, int64 *B,int64 *C)
 {
     int64 ret; 
@@ -155,8 +183,8 @@ static inline int64 Divide64(int64 *A, int64 *B,int64 *C)
     {
         throw "Divide by zero";
     }
-    if (*B>*C) //if the part in the high 64-bits is larger than the divisor then the 
-    {          //cannot fit in RAX.
+    if ((uint64)*B>=(uint64)*C) //if the part in the high 64-bits is larger than the divisor then the 
+    {                           //cannot fit in RAX.
         throw "Underflow";
     }
     asm ("div %4    \n\t"
@@ -168,18 +196,52 @@ static inline int64 Divide64(int64 *A, int64 *B,int64 *C)
 }
 
 
+// number of zero bits above the highest set bit, A must not be zero
+static inline int CountLeadingZeros64(const int64 A)
+{
+    int64 ret;
+    asm ("bsr %1,%0    \n\t"
+         :"=r" (ret)
+         : "rm" (A)
+         : "cc"
+     );
+    return 63-ret;
+}
+
+// A=A:B shifted left by Bits (shld), Bits must be less than 64
+static inline void ShiftLeft64(int64 *A,const int64 B,const int Bits)
+{
+    asm ("shld %%cl, %2, %0 \n\t"
+         : "=r" (*A)
+         : "0" (*A), "r" (B), "c" (Bits)
+         : "cc"
+        );
+}
+
+// A=B:A shifted right by Bits (shrd), Bits must be less than 64
+static inline void ShiftRight64(int64 *A,const int64 B,const int Bits)
+{
+    asm ("shrd %%cl, %2, %0 \n\t"
+         : "=r" (*A)
+         : "0" (*A), "r" (B), "c" (Bits)
+         : "cc"
+        );
+}
+
+
 //returns carry and sum in A
 static inline int Add64(int64 *A,const int64 *B,const int64 carry)
 {
-    char ret_carry =0;
+    char  ret_carry =0;
+    int64 carry_in=carry;
     asm (
-         "add %3, %0  \n\t"
+         "add $-1, %2 \n\t" //CF=carry, adding it to A first would lose a carry when A=~0
          "adc %4, %0  \n\t"
          "adc %1, %1  \n\t"
 //       "setc %1     \n\t" //appears slower than the add
 //       "cmovcq %3, %1   \n\t"
-         :"=r" (*A), "=r" (ret_carry)
-         :"0" (*A), "r" (carry), "r" (*B), "1" (ret_carry)
+         :"=r" (*A), "=r" (ret_carry), "+&r" (carry_in)
+         :"0" (*A), "r" (*B), "1" (ret_carry)
          : "cc"
     );
     return (int)ret_carry;
@@ -189,20 +251,799 @@ static inline int Add64(int64 *A,const int64 *B,const int64 carry)
 // returns if it borroed one...
 static inline int Sub64(int64 *A, const int64 *B,const int borrow)
 {
-    int ret_borrow=0;
+    int64 borrow_io=borrow;
     asm (
-        "clc                \n\t"
-         "cmp $0,%[bor]      \n\t"
-         "je  0f             \n\t"
-         "stc                \n\t"
-         "0:                 \n\t"
+         "add $-1, %[bor]    \n\t" //CF=borrow, no branch to set it up
          "sbb %[src], %[dst] \n\t"
-         "adc %[ret_bor], %[ret_bor]\n\t"
-         : [dst] "=r" (*A), [ret_bor] "=r" (ret_borrow)
-         :        "0" (*A),           "1"  (ret_borrow), [src] "r" (*B), [bor] "r" (borrow)
+         "sbb %[bor], %[bor] \n\t"
+         : [dst] "=r" (*A), [bor] "+&r" (borrow_io)
+         :        "0" (*A), [src] "r" (*B)
          : "cc"
         );
-    return ret_borrow;
+    return (int)-borrow_io;
+}
+
+//
+//
+// Broadwell and later have mulx (BMI2, a multiply that doesn't touch the flags)
+// and adcx/adox (ADX, adds that only use CF or only OF). Together they give two
+// independent carry chains that stay in the flags across a whole row of
+// multiply/adds. cpuid is checked once at startup, if the CPU doesn't have them
+// (or DOUBLEINT_NO_ADX is defined) the plain mul/adc versions are used.
+//
+//
+
+static inline bool CpuHasAdx()
+{
+#ifdef DOUBLEINT_NO_ADX
+    return false;
+#else
+    unsigned int a=0,b,c=0,d;
+    asm ("cpuid" : "+a" (a), "=b" (b), "+c" (c), "=d" (d));
+    if (a<7)
+    {
+        return false;
+    }
+    a=7;
+    c=0;
+    asm ("cpuid" : "+a" (a), "=b" (b), "+c" (c), "=d" (d));
+    return ((b>>8)&1) && ((b>>19)&1); //BMI2 and ADX
+#endif
+}
+
+static const bool DoubleIntHaveAdx=CpuHasAdx();
+
+//
+//
+// Scratch space for the limb kernels. Each thread has a bump allocator and a
+// ScratchFrame_t remembers the top when it's created and pops back to it when
+// it goes out of scope, so scratch is handed back in the reverse order it was
+// taken (which is how the kernels nest anyway). A request that doesn't fit
+// chains on another block, as big as what is in use so far. The arena keeps
+// the high water mark of what was actually in use, and when the outermost
+// frame closes a chain is replaced by a single block of that size. So once an
+// operation of a given size has run the kernels stop calling malloc, and what
+// is kept is the most that operation needed at once. Release() hands it all
+// back, for a thread that is done with big numbers for a while.
+//
+//
+
+#ifndef DOUBLEINT_SCRATCH_LIMBS
+#define DOUBLEINT_SCRATCH_LIMBS 4096   // smallest block, 32KB
+#endif
+
+class ScratchArena_t
+{
+    public:
+        // Size limbs, only good until the enclosing ScratchFrame_t goes away
+        static int64 *Get(const int Size);
+        static int64 *GetZero(const int Size);
+        // frees this thread's blocks, does nothing inside a frame
+        static void Release();
+        // limbs this thread is holding on to
+        static int64 Reserved();
+//  private:
+        struct Block_t
+        {
+            int64 *Base;
+            int64  Size;
+            int64  Used;
+        };
+        struct State_t
+        {
+            std::vector<Block_t> Blocks;
+            int   Current=0;
+            int   Frames=0;
+            int64 Below=0;  // in use in the blocks before Current
+            int64 Peak=0;   // most ever in use at once
+            ~State_t() { for (size_t x=0;x<Blocks.size();x++) ::operator delete(Blocks[x].Base);}
+        };
+        static State_t &State() { static thread_local State_t state; return state;}
+};
+
+class ScratchFrame_t
+{
+    public:
+        ScratchFrame_t();
+        ~ScratchFrame_t();
+//  private:
+        ScratchFrame_t(const ScratchFrame_t &)=delete;
+        ScratchFrame_t &operator=(const ScratchFrame_t &)=delete;
+        int   Current;
+        int64 Used;
+        int64 Below;
+};
+
+inline int64 *ScratchArena_t::Get(const int Size)
+{
+    State_t &state=State();
+    int64 *ret=NULL;
+    while (state.Current<(int)state.Blocks.size())
+    {
+        Block_t &block=state.Blocks[state.Current];
+        if (block.Used+Size<=block.Size)
+        {
+            ret=block.Base+block.Used;
+            block.Used+=Size;
+            break;
+        }
+        // anything in the blocks past the current one is stale
+        state.Below+=block.Used;
+        state.Current++;
+        if (state.Current<(int)state.Blocks.size())
+        {
+            state.Blocks[state.Current].Used=0;
+        }
+    }
+    if (ret==NULL)
+    {
+        Block_t block;
+        block.Size=(state.Below>Size)?state.Below:Size;
+        if (block.Size<DOUBLEINT_SCRATCH_LIMBS)
+        {
+            block.Size=DOUBLEINT_SCRATCH_LIMBS;
+        }
+        block.Base=(int64 *)::operator new(block.Size*sizeof(int64));
+        block.Used=Size;
+        state.Blocks.push_back(block);
+        state.Current=state.Blocks.size()-1;
+        ret=block.Base;
+    }
+    int64 inuse=state.Below+state.Blocks[state.Current].Used;
+    if (inuse>state.Peak)
+    {
+        state.Peak=inuse;
+    }
+    return ret;
+}
+
+inline int64 *ScratchArena_t::GetZero(const int Size)
+{
+    int64 *ret=Get(Size);
+    for (int x=0;x<Size;x++)
+    {
+        ret[x]=0;
+    }
+    return ret;
+}
+
+inline void ScratchArena_t::Release()
+{
+    State_t &state=State();
+    if (state.Frames!=0)
+    {
+        return;
+    }
+    for (size_t x=0;x<state.Blocks.size();x++)
+    {
+        ::operator delete(state.Blocks[x].Base);
+    }
+    state.Blocks.clear();
+    state.Current=0;
+    state.Below=0;
+    state.Peak=0;
+}
+
+inline int64 ScratchArena_t::Reserved()
+{
+    State_t &state=State();
+    int64 total=0;
+    for (size_t x=0;x<state.Blocks.size();x++)
+    {
+        total+=state.Blocks[x].Size;
+    }
+    return total;
+}
+
+inline ScratchFrame_t::ScratchFrame_t()
+{
+    ScratchArena_t::State_t &state=ScratchArena_t::State();
+    Current=state.Current;
+    Used=(Current<(int)state.Blocks.size())?state.Blocks[Current].Used:0;
+    Below=state.Below;
+    state.Frames++;
+}
+
+inline ScratchFrame_t::~ScratchFrame_t()
+{
+    ScratchArena_t::State_t &state=ScratchArena_t::State();
+    state.Current=Current;
+    state.Below=Below;
+    if (Current<(int)state.Blocks.size())
+    {
+        state.Blocks[Current].Used=Used;
+    }
+    state.Frames--;
+    if ((state.Frames==0) && (state.Blocks.size()>1))
+    {
+        // one block of the high water mark, the chain's sizes and the ends
+        // of the blocks it skipped past don't matter
+        int64 size=(state.Peak>DOUBLEINT_SCRATCH_LIMBS)?state.Peak:DOUBLEINT_SCRATCH_LIMBS;
+        for (size_t x=0;x<state.Blocks.size();x++)
+        {
+            ::operator delete(state.Blocks[x].Base);
+        }
+        state.Blocks.resize(1);
+        state.Blocks[0].Base=(int64 *)::operator new(size*sizeof(int64));
+        state.Blocks[0].Size=size;
+        state.Blocks[0].Used=0;
+        state.Current=0;
+        state.Below=0;
+    }
+}
+
+//
+//
+// Limb array helpers, these work on a flat copy of the value
+// (see GetLimbs/SetLimbs) least significant limb first. They are
+// used for the operations that don't decompose nicely into Hi/Lo halves.
+//
+//
+
+// Shift the limbs left by Count bits. Whole limbs are moved and the remaining
+// bits are merged in with a single shld pass, so the cost doesn't depend on Count.
+// Returns the last bit shifted out, like the carry flag after a shl.
+static inline int ShiftLeftLimbs(int64 *Limbs,const int Size,const int Count)
+{
+    if (Count<=0)
+    {
+        return 0;
+    }
+    if (Count>Size*64)
+    {
+        for (int x=0;x<Size;x++)
+        {
+            Limbs[x]=0;
+        }
+        return 0;
+    }
+    int bitpos=Size*64-Count;
+    int carry_ret=(((uint64)Limbs[bitpos>>6])>>(bitpos&63))&1;
+    int whole=Count>>6;
+    int bits=Count&63;
+    for (int x=Size-1;x>=0;x--)
+    {
+        int   src=x-whole;
+        int64 hi=(src>=0)?Limbs[src]:0;
+        if (bits)
+        {
+            ShiftLeft64(&hi,(src>=1)?Limbs[src-1]:0,bits);
+        }
+        Limbs[x]=hi;
+    }
+    return carry_ret;
+}
+
+// right shift version of the above, returns the last bit shifted out
+static inline int ShiftRightLimbs(int64 *Limbs,const int Size,const int Count)
+{
+    if (Count<=0)
+    {
+        return 0;
+    }
+    if (Count>Size*64)
+    {
+        for (int x=0;x<Size;x++)
+        {
+            Limbs[x]=0;
+        }
+        return 0;
+    }
+    int bitpos=Count-1;
+    int carry_ret=(((uint64)Limbs[bitpos>>6])>>(bitpos&63))&1;
+    int whole=Count>>6;
+    int bits=Count&63;
+    for (int x=0;x<Size;x++)
+    {
+        int   src=x+whole;
+        int64 lo=(src<Size)?Limbs[src]:0;
+        if (bits)
+        {
+            ShiftRight64(&lo,(src+1<Size)?Limbs[src+1]:0,bits);
+        }
+        Limbs[x]=lo;
+    }
+    return carry_ret;
+}
+
+
+// A+=B over Size limbs, returns the carry. The carry stays in CF for the
+// whole loop, dec and lea don't touch it.
+static inline int AddLimbs(int64 *A,const int64 *B,const int Size,const int carry)
+{
+    if (Size<=0)
+    {
+        return carry;
+    }
+    int64 carry_io=carry;
+    int64 x=0;
+    int64 count=Size;
+    int64 tmp;
+    asm volatile ("add $-1, %[carry]         \n\t"
+         "0:                        \n\t"
+         "mov (%[a],%[x],8), %[tmp] \n\t"
+         "adc (%[b],%[x],8), %[tmp] \n\t"
+         "mov %[tmp], (%[a],%[x],8) \n\t"
+         "lea 1(%[x]), %[x]         \n\t"
+         "dec %[count]              \n\t"
+         "jnz 0b                    \n\t"
+         "sbb %[carry], %[carry]    \n\t"
+         : [carry] "+&r" (carry_io), [x] "+&r" (x), [count] "+&r" (count), [tmp] "=&r" (tmp)
+         : [a] "r" (A), [b] "r" (B)
+         : "cc", "memory"
+        );
+    return (int)-carry_io;
+}
+
+// A-=B over Size limbs, returns the borrow
+static inline int SubLimbs(int64 *A,const int64 *B,const int Size,const int borrow)
+{
+    if (Size<=0)
+    {
+        return borrow;
+    }
+    int64 borrow_io=borrow;
+    int64 x=0;
+    int64 count=Size;
+    int64 tmp;
+    asm volatile ("add $-1, %[borrow]        \n\t"
+         "0:                        \n\t"
+         "mov (%[a],%[x],8), %[tmp] \n\t"
+         "sbb (%[b],%[x],8), %[tmp] \n\t"
+         "mov %[tmp], (%[a],%[x],8) \n\t"
+         "lea 1(%[x]), %[x]         \n\t"
+         "dec %[count]              \n\t"
+         "jnz 0b                    \n\t"
+         "sbb %[borrow], %[borrow]  \n\t"
+         : [borrow] "+&r" (borrow_io), [x] "+&r" (x), [count] "+&r" (count), [tmp] "=&r" (tmp)
+         : [a] "r" (A), [b] "r" (B)
+         : "cc", "memory"
+        );
+    return (int)-borrow_io;
+}
+
+// AddMulLimb with mulx, the high halves of the products ripple through CF
+// (adcx) and the adds into R ripple through OF (adox). The loop counters are
+// tested with jrcxz and stepped with lea so neither flag is disturbed. The odd
+// limbs are done first, then the rest four at a time.
+static inline int64 AddMulLimbAdx(int64 *R,const int64 *A,const int Size,const int64 B)
+{
+    int64 carry=0;
+    int64 x=0;
+    int64 count=Size&3;
+    int64 blocks=Size>>2;
+    int64 lo,hi;
+    asm volatile ("xor %%eax, %%eax                  \n\t" //clears CF and OF
+         "0:                                \n\t"
+         "jrcxz 1f                          \n\t"
+         "mulx (%[a],%[x],8), %[lo], %[hi]  \n\t"
+         "adcx %[carry], %[lo]              \n\t"
+         "adox (%[r],%[x],8), %[lo]         \n\t"
+         "mov %[lo], (%[r],%[x],8)          \n\t"
+         "mov %[hi], %[carry]               \n\t"
+         "lea 1(%[x]), %[x]                 \n\t"
+         "lea -1(%%rcx), %%rcx              \n\t"
+         "jmp 0b                            \n\t"
+         "1:                                \n\t"
+         "mov %[blocks], %%rcx              \n\t"
+         "2:                                \n\t"
+         "jrcxz 3f                          \n\t"
+         "mulx (%[a],%[x],8), %[lo], %[hi]  \n\t"
+         "adcx %[carry], %[lo]              \n\t"
+         "adox (%[r],%[x],8), %[lo]         \n\t"
+         "mov %[lo], (%[r],%[x],8)          \n\t"
+         "mulx 8(%[a],%[x],8), %[lo], %[carry] \n\t"
+         "adcx %[hi], %[lo]                 \n\t"
+         "adox 8(%[r],%[x],8), %[lo]        \n\t"
+         "mov %[lo], 8(%[r],%[x],8)         \n\t"
+         "mulx 16(%[a],%[x],8), %[lo], %[hi] \n\t"
+         "adcx %[carry], %[lo]              \n\t"
+         "adox 16(%[r],%[x],8), %[lo]       \n\t"
+         "mov %[lo], 16(%[r],%[x],8)        \n\t"
+         "mulx 24(%[a],%[x],8), %[lo], %[carry] \n\t"
+         "adcx %[hi], %[lo]                 \n\t"
+         "adox 24(%[r],%[x],8), %[lo]       \n\t"
+         "mov %[lo], 24(%[r],%[x],8)        \n\t"
+         "lea 4(%[x]), %[x]                 \n\t"
+         "lea -1(%%rcx), %%rcx              \n\t"
+         "jmp 2b                            \n\t"
+         "3:                                \n\t"
+         "adcx %%rax, %[carry]              \n\t" //rax is still 0, fold both chains in
+         "adox %%rax, %[carry]              \n\t"
+         : [carry] "+&r" (carry), [x] "+&r" (x), "+&c" (count), [lo] "=&r" (lo), [hi] "=&r" (hi)
+         : [a] "r" (A), [r] "r" (R), "d" (B), [blocks] "r" (blocks)
+         : "rax", "cc", "memory"
+        );
+    return carry;
+}
+
+// R+=A*B where B is a single limb, returns the limb carried out the top
+// R+A*B+carry always fits in rdx:rax so the carry limb never overflows
+static inline int64 AddMulLimb(int64 *R,const int64 *A,const int Size,const int64 B)
+{
+    int64 carry=0;
+    if (Size<=0)
+    {
+        return 0;
+    }
+    if (DoubleIntHaveAdx)
+    {
+        return AddMulLimbAdx(R,A,Size,B);
+    }
+    int64 x=0;
+    int64 count=Size;
+    asm volatile ("0:                      \n\t"
+         "mov (%[a],%[x],8), %%rax \n\t"
+         "mul %[b]                \n\t"
+         "add %[carry], %%rax     \n\t"
+         "adc $0, %%rdx           \n\t"
+         "add %%rax, (%[r],%[x],8) \n\t"
+         "adc $0, %%rdx           \n\t"
+         "mov %%rdx, %[carry]     \n\t"
+         "inc %[x]                \n\t"
+         "dec %[count]            \n\t"
+         "jnz 0b                  \n\t"
+         : [carry] "+&r" (carry), [x] "+&r" (x), [count] "+&r" (count)
+         : [a] "r" (A), [r] "r" (R), [b] "r" (B)
+         : "rax", "rdx", "cc", "memory"
+        );
+    return carry;
+}
+
+// R-=A*B where B is a single limb, returns the limb borrowed from above the top
+// same as AddMulLimb, A*B+borrow+1 still fits in rdx:rax
+static inline int64 SubMulLimb(int64 *R,const int64 *A,const int Size,const int64 B)
+{
+    int64 borrow=0;
+    if (Size<=0)
+    {
+        return 0;
+    }
+    int64 x=0;
+    int64 count=Size;
+    asm volatile ("0:                      \n\t"
+         "mov (%[a],%[x],8), %%rax \n\t"
+         "mul %[b]                \n\t"
+         "add %[borrow], %%rax    \n\t"
+         "adc $0, %%rdx           \n\t"
+         "sub %%rax, (%[r],%[x],8) \n\t"
+         "adc $0, %%rdx           \n\t"
+         "mov %%rdx, %[borrow]    \n\t"
+         "inc %[x]                \n\t"
+         "dec %[count]            \n\t"
+         "jnz 0b                  \n\t"
+         : [borrow] "+&r" (borrow), [x] "+&r" (x), [count] "+&r" (count)
+         : [a] "r" (A), [r] "r" (R), [b] "r" (B)
+         : "rax", "rdx", "cc", "memory"
+        );
+    return borrow;
+}
+
+// R[0..ASize+BSize)=A*B, the grade school method one row at a time
+static inline void MultiplyLimbsBasecase(int64 *R,const int64 *A,const int ASize,const int64 *B,const int BSize)
+{
+    for (int x=0;x<ASize;x++)
+    {
+        R[x]=0;
+    }
+    for (int x=0;x<BSize;x++)
+    {
+        R[ASize+x]=AddMulLimb(&R[x],A,ASize,B[x]);
+    }
+}
+
+// R[0..2*Size)=A*A, each cross product A[x]*A[y] (x<y) is only computed once
+// then the whole triangle is doubled with a shift and the diagonal is added in
+static inline void SquareLimbsBasecase(int64 *R,const int64 *A,const int Size)
+{
+    for (int x=0;x<2*Size;x++)
+    {
+        R[x]=0;
+    }
+    for (int x=0;x<Size-1;x++)
+    {
+        R[Size+x]=AddMulLimb(&R[2*x+1],&A[x+1],Size-x-1,A[x]);
+    }
+    ShiftLeftLimbs(R,2*Size,1);
+    int carry=0;
+    for (int x=0;x<Size;x++)
+    {
+        int64 lo=A[x];
+        int64 hi=Multiply64(&lo,&lo);
+        carry=Add64(&R[2*x],&lo,carry);
+        carry=Add64(&R[2*x+1],&hi,carry);
+    }
+}
+
+// Mixed width helpers, B is only BSize limbs (BSize<=Size) so only those limbs
+// are worked on and a carry or borrow ripples up only as far as it needs to.
+// A+=B, returns the carry out the top
+static inline int AddLimbsShort(int64 *A,const int Size,const int64 *B,const int BSize)
+{
+    int carry=AddLimbs(A,B,BSize,0);
+    for (int x=BSize;(x<Size) && carry;x++)
+    {
+        carry=(++A[x]==0);
+    }
+    return carry;
+}
+
+// A-=B, returns the borrow out the top
+static inline int SubLimbsShort(int64 *A,const int Size,const int64 *B,const int BSize)
+{
+    int borrow=SubLimbs(A,B,BSize,0);
+    for (int x=BSize;(x<Size) && borrow;x++)
+    {
+        borrow=(A[x]--==0);
+    }
+    return borrow;
+}
+
+// A=A*B keeping the low Size limbs. It works down from the top limb of A so
+// each row can go straight back into A, and rows are cut off at Size.
+static inline void MultiplyLimbsShort(int64 *A,const int Size,const int64 *B,const int BSize)
+{
+    if (BSize==1)
+    {
+        int64 b=B[0];
+        int64 carry=0;
+        for (int x=0;x<Size;x++)
+        {
+            int64 lo=A[x];
+            int64 hi=Multiply64(&lo,&b);
+            hi+=Add64(&lo,&carry,0);
+            A[x]=lo;
+            carry=hi;
+        }
+        return;
+    }
+    for (int x=Size-1;x>=0;x--)
+    {
+        int64 a=A[x];
+        int len=(BSize<Size-x)?BSize:Size-x;
+        A[x]=0;
+        int64 carry=AddMulLimb(&A[x],B,len,a);
+        for (int y=x+len;(y<Size) && carry;y++)
+        {
+            int64 add=carry;
+            carry=Add64(&A[y],&add,0);
+        }
+    }
+}
+
+// A compared with B, -1 0 or 1
+static inline int CompareLimbsShort(const int64 *A,const int Size,const int64 *B,const int BSize)
+{
+    for (int x=Size-1;x>=BSize;x--)
+    {
+        if (A[x]!=0)
+        {
+            return 1;
+        }
+    }
+    for (int x=BSize-1;x>=0;x--)
+    {
+        if (A[x]!=B[x])
+        {
+            return ((uint64)A[x]>(uint64)B[x])?1:-1;
+        }
+    }
+    return 0;
+}
+
+// A/=B where B is a single limb, walks from the top limb down 
+// with the hardware divide. Returns the remainder.
+static inline int64 DivideLimbsByLimb(int64 *A,const int Size,const int64 B)
+{
+    int64 remainder=0;
+    int64 divisor=B;
+    for (int x=Size-1;x>=0;x--)
+    {
+        remainder=Divide64(&A[x],&remainder,&divisor);
+    }
+    return remainder;
+}
+
+// Plain C++ versions of the limb helpers for compile time. The asm can't be
+// evaluated by the compiler, unsigned __int128 can (and does the 64x64
+// multiply with a single mul at run time anyway).
+// A=A*B+Carry, returns the limb carried out the top
+static constexpr int64 ConstMulAddLimb(int64 *A,const int Size,const int64 B,const int64 Carry)
+{
+    uint64 carry=Carry;
+    for (int x=0;x<Size;x++)
+    {
+        unsigned __int128 t=(unsigned __int128)(uint64)A[x]*(uint64)B+carry;
+        A[x]=(int64)(uint64)t;
+        carry=(uint64)(t>>64);
+    }
+    return (int64)carry;
+}
+
+// Reads a base 10 or base 16 (0x) string into Size limbs, anything that
+// doesn't fit falls off the top. Leading junk is skipped and ' separators
+// (like in a C++ literal) are allowed. Decimal goes 19 digits per multiply/add
+// pass, and only over the limbs in use so far. Hex digits just get dropped
+// into place from the bottom.
+static constexpr void ParseLimbs(int64 *Limbs,const int Size,const char *Source)
+{
+    int start=0;
+    int base=10;
+    for (int x=0;x<Size;x++)
+    {
+        Limbs[x]=0;
+    }
+    while (Source[start]!='\0')
+    {
+        if (Source[start]=='0')
+        {
+            if ((Source[start+1]=='x') || (Source[start+1]=='X'))
+            {
+                base=16;
+                start+=2;
+            }
+            break;
+        }
+        if ((Source[start]>='0') && (Source[start]<='9'))
+        {
+            break;
+        }
+        start++;
+    }
+    if (base==10)
+    {
+        int used=0;
+        while (((Source[start]>='0') && (Source[start]<='9')) || (Source[start]=='\''))
+        {
+            uint64 chunk=0;
+            uint64 scale=1;
+            for (int x=0;(x<19) && (((Source[start]>='0') && (Source[start]<='9')) || (Source[start]=='\''));start++)
+            {
+                if (Source[start]!='\'')
+                {
+                    chunk=chunk*10+(Source[start]-'0');
+                    scale*=10;
+                    x++;
+                }
+            }
+            int64 carry=ConstMulAddLimb(Limbs,used,(int64)scale,(int64)chunk);
+            if ((carry!=0) && (used<Size))
+            {
+                Limbs[used++]=carry;
+            }
+        }
+    }
+    else
+    {
+        int end=start;
+        while (((Source[end]>='0') && (Source[end]<='9')) || (((Source[end]|0x20)>='a') && ((Source[end]|0x20)<='f')) || (Source[end]=='\''))
+        {
+            end++;
+        }
+        int nibble=0;
+        for (int x=end-1;(x>=start) && (nibble<Size*16);x--)
+        {
+            if (Source[x]!='\'')
+            {
+                uint64 digit=(Source[x]<='9')?Source[x]-'0':(Source[x]|0x20)-'a'+10;
+                Limbs[nibble>>4]|=(int64)(digit<<((nibble&15)*4));
+                nibble++;
+            }
+        }
+    }
+}
+
+// Q=A/B and R=A%B, all Size limbs. This is Knuth's Algorithm D (TAOCP vol 2,
+// 4.3.1). The divisor is normalized so its top bit is set, then each quotient
+// limb is estimated from the top two remainder limbs with the hardware divide.
+// That estimate is at most 2 too large, the next divisor limb catches nearly
+// all of those and the multiply/subtract catches the rest.
+static inline void DivideLimbs(int64 *Q,int64 *R,const int64 *A,const int64 *B,const int Size)
+{
+    int n=Size;
+    while ((n>0) && (B[n-1]==0))
+    {
+        n--;
+    }
+    if (n==0)
+    {
+        throw "division by zero";
+    }
+    int m=Size;
+    while ((m>0) && (A[m-1]==0))
+    {
+        m--;
+    }
+    for (int x=0;x<Size;x++)
+    {
+        Q[x]=0;
+        R[x]=0;
+    }
+    if (m<n)
+    {
+        for (int x=0;x<m;x++)
+        {
+            R[x]=A[x];
+        }
+        return;
+    }
+    if (n==1)
+    {
+        for (int x=0;x<m;x++)
+        {
+            Q[x]=A[x];
+        }
+        R[0]=DivideLimbsByLimb(Q,m,B[0]);
+        return;
+    }
+
+    // normalize
+    int shift=CountLeadingZeros64(B[n-1]);
+    ScratchFrame_t frame;
+    int64 *u=ScratchArena_t::Get(m+1);
+    int64 *v=ScratchArena_t::Get(n);
+    for (int x=0;x<n;x++)
+    {
+        v[x]=B[x];
+    }
+    for (int x=0;x<m;x++)
+    {
+        u[x]=A[x];
+    }
+    u[m]=0;
+    ShiftLeftLimbs(v,n,shift);
+    ShiftLeftLimbs(u,m+1,shift);
+    int64 vtop=v[n-1];
+    int64 vnext=v[n-2];
+
+    for (int j=m-n;j>=0;j--)
+    {
+        int64 qhat;
+        int64 rhat;
+        int   rhatcarry=0;
+        if (u[j+n]==vtop) //the quotient limb would overflow, start at the max
+        {
+            qhat=-1;
+            rhat=u[j+n-1];
+            rhatcarry=Add64(&rhat,&vtop,0);
+        }
+        else
+        {
+            int64 hi=u[j+n];
+            qhat=u[j+n-1];
+            rhat=Divide64(&qhat,&hi,&vtop);
+        }
+        // qhat*vnext>rhat:u[j+n-2] means qhat is too big
+        while (!rhatcarry)
+        {
+            int64 plo=qhat;
+            int64 phi=Multiply64(&plo,&vnext);
+            if (((uint64)phi<(uint64)rhat) || ((phi==rhat) && ((uint64)plo<=(uint64)u[j+n-2])))
+            {
+                break;
+            }
+            qhat--;
+            rhatcarry=Add64(&rhat,&vtop,0);
+        }
+
+        // u-=qhat*v, if that went negative qhat was still one too big so add v back
+        int64 borrow=SubMulLimb(&u[j],v,n,qhat);
+        int64 top=u[j+n];
+        u[j+n]-=borrow;
+        if ((uint64)top<(uint64)borrow)
+        {
+            qhat--;
+            u[j+n]+=AddLimbs(&u[j],v,n,0);
+        }
+        Q[j]=qhat;
+    }
+
+    // unnormalize the remainder
+    ShiftRightLimbs(u,n,shift);
+    for (int x=0;x<n;x++)
+    {
+        R[x]=u[x];
+    }
 }
 
 //
@@ -213,30 +1054,153 @@ static inline int Sub64(int64 *A, const int64 *B,const int borrow)
 //
 
 // A-=B; returns borrow
+// the borrow between the halves stays in CF rather than going through a register
 inline int int128_t::SubDouble(int128_t *A,const int128_t &B,const int borrow)
 {
-    int ret_borrow;
-    ret_borrow=Sub64(&A->Lo,&B.Lo,borrow);
-    ret_borrow=Sub64(&A->Hi,&B.Hi,ret_borrow);
-    return ret_borrow;
+    int64 borrow_io=borrow;
+    asm ("add $-1, %[bor]     \n\t"
+         "sbb %[blo], %[lo]   \n\t"
+         "sbb %[bhi], %[hi]   \n\t"
+         "sbb %[bor], %[bor]  \n\t"
+         : [lo] "+&r" (A->Lo), [hi] "+&r" (A->Hi), [bor] "+&r" (borrow_io)
+         : [blo] "rm" (B.Lo), [bhi] "rm" (B.Hi)
+         : "cc"
+        );
+    return (int)-borrow_io;
 }
 
 
 inline int int128_t::AddDouble(int128_t *A,const int128_t &B,const int carry)
 {
-    int carry_ret=0;
-    carry_ret=Add64(&A->Lo,&B.Lo,carry);
-    carry_ret=Add64(&A->Hi,&B.Hi,carry_ret);
-    return carry_ret;
+    int64 carry_io=carry;
+    asm ("add $-1, %[carry]      \n\t"
+         "adc %[blo], %[lo]      \n\t"
+         "adc %[bhi], %[hi]      \n\t"
+         "sbb %[carry], %[carry] \n\t"
+         : [lo] "+&r" (A->Lo), [hi] "+&r" (A->Hi), [carry] "+&r" (carry_io)
+         : [blo] "rm" (B.Lo), [bhi] "rm" (B.Hi)
+         : "cc"
+        );
+    return (int)-carry_io;
 }
 
 
+// A=A*B keeping only the low 128 bits. Only bd needs the full 64x64 multiply,
+// the high halves of ad and bc and all of ac land above the result.
+inline void int128_t::MultiplyLow(int128_t *A,const int128_t &B)
+{
+    int64 lo=A->Lo;
+    int64 d=B.Lo;
+    int64 hi=Multiply64(&lo,&d);
+    hi+=(uint64)A->Hi*(uint64)B.Lo+(uint64)A->Lo*(uint64)B.Hi;
+    A->Lo=lo;
+    A->Hi=hi;
+}
+
+// (ret:A)=A+B*C, the multiply and the add both stay in registers
+inline int128_t int128_t::AddMulDouble(int128_t *A,const int128_t &B,const int128_t &C)
+{
+    int128_t lo=B;
+    int128_t hi=MultiplyDouble(&lo,C);
+    int carry=AddDouble(&lo,*A,0);
+    int128_t zero=0;
+    AddDouble(&hi,zero,carry);
+    *A=lo;
+    return hi;
+}
+
+// A-=B*C, returns what that borrowed from above (A-B*C=A'-ret*2^128)
+inline int128_t int128_t::SubMulDouble(int128_t *A,const int128_t &B,const int128_t &C)
+{
+    int128_t lo=B;
+    int128_t hi=MultiplyDouble(&lo,C);
+    int borrow=SubDouble(A,lo,0);
+    int128_t zero=0;
+    AddDouble(&hi,zero,borrow);
+    return hi;
+}
+
+// A+=B*C for a single limb C, returns the limb carried out the top
+inline int64 int128_t::AddMulLimb(int128_t *A,const int128_t &B,const int64 C)
+{
+    return ::AddMulLimb(LimbPtr(A),LimbPtr(B),limbs,C);
+}
+
+// A-=B*C for a single limb C, returns the limb borrowed from above
+inline int64 int128_t::SubMulLimb(int128_t *A,const int128_t &B,const int64 C)
+{
+    return ::SubMulLimb(LimbPtr(A),LimbPtr(B),limbs,C);
+}
+
+// A=(Remainder:A)/B returns the remainder, B is treated as unsigned and 
+// Remainder must be less than B. The Remainder parameter lets the doubler 
+// chain the Hi and Lo halves together.
+inline int64 int128_t::DivideByLimb(int128_t *A,const int64 B,const int64 Remainder)
+{
+    int64 divisor=B;
+    int64 remainder=Remainder;
+    remainder=Divide64(&A->Hi,&remainder,&divisor);
+    remainder=Divide64(&A->Lo,&remainder,&divisor);
+    return remainder;
+}
+
+// (Remainder:A)%B
+inline int64 int128_t::ModByLimb(const int128_t &A,const int64 B,const int64 Remainder)
+{
+    int128_t tmp=A;
+    return DivideByLimb(&tmp,B,Remainder);
+}
+
+
+// MultiplyDouble with mulx. The four products are summed with bc going down
+// the CF chain and ad down the OF chain.
+//        z   = bd.lo
+//    y       = bd.hi+bc.lo+ad.lo
+//  x         = ac.lo+bc.hi+ad.hi
+//w           = ac.hi+carries
+inline int128_t int128_t::MultiplyDoubleAdx(int128_t *A,const int128_t &B)
+{
+    int128 ret;
+    int64 w,x,y,z,t1,t2,t3;
+    int64 dx=A->Lo;
+    asm ("xor  %k[t3], %k[t3]     \n\t" //clears CF and OF
+         "mulx %[d], %[z], %[y]   \n\t" //bd
+         "mulx %[c], %[t1], %[x]  \n\t" //bc
+         "mov  %[a], %%rdx        \n\t"
+         "mulx %[d], %[t2], %[t3] \n\t" //ad
+         "adcx %[t1], %[y]        \n\t"
+         "adox %[t2], %[y]        \n\t"
+         "mulx %[c], %[t1], %[w]  \n\t" //ac
+         "adcx %[t1], %[x]        \n\t"
+         "adox %[t3], %[x]        \n\t"
+         "mov  $0, %k[t1]         \n\t"
+         "adcx %[t1], %[w]        \n\t"
+         "adox %[t1], %[w]        \n\t"
+         : [w] "=&r" (w), [x] "=&r" (x), [y] "=&r" (y), [z] "=&r" (z), [t1] "=&r" (t1), [t2] "=&r" (t2), [t3] "=&r" (t3), "+d" (dx)
+         : [a] "rm" (A->Hi), [c] "rm" (B.Hi), [d] "rm" (B.Lo)
+         : "cc"
+        );
+    A->Lo=z;
+    A->Hi=y;
+    ret.Lo=x;
+    ret.Hi=w;
+    return ret;
+}
+
 // Ha, this is a 256bit multiply, it takes two 128 bit sources and creates a 128bit destination and 128bit overflow..
 // this general code path can be abstracted into a template to generate any arbitraty length multiply as long as 
 // we have a 64bit base class... For template testing we could create a 32-bit base class and compare the results 
 // with a 64-bit result
 inline int128_t int128_t::MultiplyDouble(int128_t *A,const int128_t &B)
 {
+    if (A==&B)
+    {
+        return SquareDouble(A);
+    }
+    if (DoubleIntHaveAdx)
+    {
+        return MultiplyDoubleAdx(A,B);
+    }
     int128 ret;
     int64  tmp=0;
     int64  col3=0;
@@ -276,7 +1240,7 @@ inline int128_t int128_t::MultiplyDouble(int128_t *A,const int128_t &B)
     w=Multiply64(&a,&c); 
     carry2=Add64(&x,&a,carry2);//x+=a; 
     // final w fixup
-    int64 longcarry=carry2;
+    int64 longcarry=carry; //carry out of x+=xp
     Add64(&w,&longcarry,carry2);
 
 
@@ -289,6 +1253,85 @@ inline int128_t int128_t::MultiplyDouble(int128_t *A,const int128_t &B)
 }
 
 
+// SquareDouble with mulx, the cross product is added in twice (once down
+// each carry chain) instead of being shifted
+inline int128_t int128_t::SquareDoubleAdx(int128_t *A)
+{
+    int128 ret;
+    int64 w,x,y,z,m0,m1;
+    int64 dx=A->Lo;
+    asm ("xor  %k[m1], %k[m1]     \n\t" //clears CF and OF
+         "mulx %%rdx, %[z], %[y]  \n\t" //bb
+         "mulx %[a], %[m0], %[m1] \n\t" //ab
+         "mov  %[a], %%rdx        \n\t"
+         "mulx %%rdx, %[x], %[w]  \n\t" //aa
+         "adcx %[m0], %[y]        \n\t"
+         "adox %[m0], %[y]        \n\t"
+         "adcx %[m1], %[x]        \n\t"
+         "adox %[m1], %[x]        \n\t"
+         "mov  $0, %k[m0]         \n\t"
+         "adcx %[m0], %[w]        \n\t"
+         "adox %[m0], %[w]        \n\t"
+         : [w] "=&r" (w), [x] "=&r" (x), [y] "=&r" (y), [z] "=&r" (z), [m0] "=&r" (m0), [m1] "=&r" (m1), "+d" (dx)
+         : [a] "rm" (A->Hi)
+         : "cc"
+        );
+    A->Lo=z;
+    A->Hi=y;
+    ret.Lo=x;
+    ret.Hi=w;
+    return ret;
+}
+
+// Same contract as MultiplyDouble with B==A. The two cross products (ad and bc)
+// are the same thing, so compute it once and double it with a shift.
+//   ab
+//*  ab
+//------
+//   bb
+// 2ab
+//+aa
+//-------
+// wxyz
+inline int128_t int128_t::SquareDouble(int128_t *A)
+{
+    if (DoubleIntHaveAdx)
+    {
+        return SquareDoubleAdx(A);
+    }
+    int128 ret;
+    int64 a=A->Hi;
+    int64 b=A->Lo;
+    int64 w=0;
+    int64 x=0;
+    int64 y=0;
+    int64 z=0;
+    int   carry=0;
+
+    z=b;
+    y=Multiply64(&z,&b);
+    x=a;
+    w=Multiply64(&x,&a);
+    int64 mlo=b;
+    int64 mhi=Multiply64(&mlo,&a);
+    // 2ab
+    int64 mtop=(uint64)mhi>>63;
+    mhi=(mhi<<1)|((uint64)mlo>>63);
+    mlo<<=1;
+
+    carry=Add64(&y,&mlo,0);
+    carry=Add64(&x,&mhi,carry);
+    Add64(&w,&mtop,carry);
+
+    A->Lo=z;
+    A->Hi=y;
+    ret.Lo=x;
+    ret.Hi=w;
+
+    return ret;
+}
+
+
 // Sort of satanic because of all the carry nonsense being propagated in and out of the flags
 // for an arbitrary length integer the fastest way to do this is to put all the rcr's in a loop
 // or unroll them instead of putting all the carry flag checking everywhere
@@ -354,35 +1397,43 @@ int int128_t::shiftleft(int128 *Value,const int Carry_prm)
     return Carry_ret;
 }
 
+// multi bit shifts, returns the last bit shifted out
+inline int int128_t::shiftleftn(int128_t *Value,const int Count)
+{
+    int64 limb[limbs];
+    GetLimbs(*Value,limb);
+    int carry_ret=ShiftLeftLimbs(limb,limbs,Count);
+    SetLimbs(Value,limb);
+    return carry_ret;
+}
+
+
+inline int int128_t::shiftrightn(int128_t *Value,const int Count)
+{
+    int64 limb[limbs];
+    GetLimbs(*Value,limb);
+    int carry_ret=ShiftRightLimbs(limb,limbs,Count);
+    SetLimbs(Value,limb);
+    return carry_ret;
+}
+
 // from what I understand there are really only a couple of algorithms
 // useful for really long integer divides. My original plan was to 
 // do some form of broken up radix 2^64 divide, but that doesn't actually
-// work without making sure the dividend is less than 2^64, if thats the case
-// we could make a really fast arbitrarily long dividend division. I'm afraid I don't
-// want to make that restriction so, I'm back to the old school, shift and subtract method.
+// work without making sure the dividend is less than 2^64. Knuth's fix for that
+// is to normalize the divisor and correct the estimated quotient limbs, which
+// is what DivideLimbs does, so the old shift and subtract loop is gone.
 // A=A/B Ret=Remainder
 int128_t int128_t::DivideDouble(int128_t *A,const int128_t &B)
 {
-    int128 quotient=*A;
-    int128 remainder;//==0
+    int128 remainder;
+    int64  a[2],b[2],q[2],r[2];
 
-    if ((int128_t)(B)==0) //TODO: fix this const mess
-    {
-        throw "division by zero";
-    }
-    
-    for (int x=0;x<A->size;x++)
-    {
-        int hibit=shiftleft(&quotient,0);
-        shiftleft(&remainder,hibit);
-        if (remainder>=B)
-        {
-            SubDouble(&remainder,B,0); //remainder-=*B;
-            quotient.Lo|=1; //quotient|=1;
-        }
-    }
-
-    *A=quotient;
+    GetLimbs(*A,a);
+    GetLimbs(B,b);
+    DivideLimbs(q,r,a,b,2);
+    SetLimbs(A,q);
+    SetLimbs(&remainder,r);
     return remainder;
 }
 
@@ -424,6 +1475,25 @@ string int128_t::AsString(const char *format)
     switch (format[1])
     {
         case 'd':
+        {
+            // split into two 19 digit chunks (and a top digit) with the hardware divide
+            int128_t tmp;
+            tmp=*this;
+            int64 lo=DivideByLimb(&tmp,DECIMAL_CHUNK);
+            int64 mid=DivideByLimb(&tmp,DECIMAL_CHUNK);
+            if (tmp.Lo)
+            {
+                sprintf(temp,"%llu%019llu%019llu",(uint64)tmp.Lo,(uint64)mid,(uint64)lo);
+            }
+            else if (mid)
+            {
+                sprintf(temp,"%llu%019llu",(uint64)mid,(uint64)lo);
+            }
+            else
+            {
+                sprintf(temp,"%llu",(uint64)lo);
+            }
+        }
             break;
         case 'b':
             break;
@@ -444,10 +1514,7 @@ string int128_t::AsString(const char *format)
                 {
                     temp[x]+='0';
                 }
-                shiftright(&tmp,0);
-                shiftright(&tmp,0);
-                shiftright(&tmp,0);
-                shiftright(&tmp,0);
+                shiftrightn(&tmp,4);
             }
         }
         break;